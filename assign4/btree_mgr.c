@@ -36,6 +36,8 @@ int totalKeyCount;
 int currentScanPosition;
 // Array of pointers to IndexTree nodes
 IndexTree **indexTreeArray;
+// Shared buffer pool of the indexes, NULL gives every index a pool of its own
+static BM_BufferPool *sharedPool = NULL;
 
 // helper functions
 int compareKeys(Value *key1, Value *key2);
@@ -54,7 +56,8 @@ static void removeTrailingComma(char *str);
 
 RC initIndexManager(void *mgmtData)
 {
-    // nothing for init
+    // mgmtData may point to a shared buffer pool the indexes opened from now on attach to
+    sharedPool = (BM_BufferPool *)mgmtData;
     return RC_OK;
 }
 
@@ -67,6 +70,7 @@ RC shutdownIndexManager()
     }
     // free whole IndexTreeArray at the end
     free(indexTreeArray);
+    sharedPool = NULL;
     return RC_OK;
 }
 
@@ -212,8 +216,9 @@ RC openBtree(BTreeHandle **tree, char *idxId)
         return RC_MEM_ALLOC_FAILURE;
     }
 
-    // Initialize buffer pool
-    status = initBufferPool(treeData->bufferPool, idxId, NUM_OF_PAGES, RS_FIFO, NULL);
+    // Initialize buffer pool, or attach the index to the shared one
+    status = sharedPool != NULL ? attachPageFile(treeData->bufferPool, sharedPool, idxId)
+                                : initBufferPool(treeData->bufferPool, idxId, NUM_OF_PAGES, RS_FIFO, NULL);
     if (status != RC_OK)
     {
         free(treeData->pageHandle);
@@ -323,8 +328,8 @@ RC getNumNodes(BTreeHandle *tree, int *result)
         int previousNode = currentNode - 1;
         while (previousNode >= 0)
         {
-            int currentPage = indexTreeArray[currentNode]->rid.page;
-            int previousPage = indexTreeArray[previousNode]->rid.page;
+            PageNumber currentPage = indexTreeArray[currentNode]->rid.page;
+            PageNumber previousPage = indexTreeArray[previousNode]->rid.page;
             if (currentPage == previousPage)
             {
                 duplicatePageCount++;
@@ -802,7 +807,7 @@ char *printTree(BTreeHandle *tree)
         }
 
         // Add key and RID information
-        appendToString(resultString, "%d.%d, %d,",
+        appendToString(resultString, "%lld.%d, %d,",
                        indexTreeArray[index]->rid.page,
                        indexTreeArray[index]->rid.slot,
                        indexTreeArray[index]->value.v.intV);
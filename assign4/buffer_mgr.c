@@ -1,711 +1,4280 @@
 #include "dt.h"
 #include "buffer_mgr.h"
 #include <string.h>
-#include <sys/stat.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "storage_mgr.h"
 
 typedef struct BufferPoolFrame
 {
     int indexpool;
     struct BufferPoolFrame *nextFrame;
-    int indexpage;
+    PageNumber indexpage;
     struct BufferPoolFrame *prevFrame;
 } BufferPoolFrame;
 
+// Slot of a page table; free slots hold NO_PAGE
+typedef struct PageTableEntry
+{
+    PageNumber pageNum;
+    int frame;
+} PageTableEntry;
+
+// Open addressing (linear probing) map from page number to a slot index
+typedef struct PageTable
+{
+    PageTableEntry *entries;
+    int mask;
+} PageTable;
+
+// Struct to maintain page access history
+typedef struct PageAccessHistory
+{
+    long long *accessTimes; // Store the last K access times, a ring indexed by count % K
+    long long count;        // no. of times the page was accessed
+} PageAccessHistory;
+
+// RS_LRU_K bookkeeping, only allocated for pools using that strategy
+typedef struct LRUKData
+{
+    int k;
+    int numFrames;
+    long long clock; // logical time, advanced on every pin
+
+    // access history of the page in each frame
+    PageAccessHistory *history;
+
+    // min-heap of the unpinned frames ordered by backward K-distance, and the
+    // position of each frame in it (-1 while the frame is pinned or empty)
+    int *heap;
+    int *heapPos;
+    int heapSize;
+
+    // history retained for recently evicted pages, replaced round robin
+    PageTable retainedIndex;
+    PageNumber *retainedPages;
+    PageAccessHistory *retained;
+    int retainedNext;
+
+    // backing memory of all accessTimes rings
+    long long *times;
+} LRUKData;
+
+// RS_LFU: frames with the same use count, most recently used at the head
+typedef struct LFUBucket
+{
+    long long freq;
+    int head;
+    int tail;
+    struct LFUBucket *prev; // next lower frequency
+    struct LFUBucket *next; // next higher frequency
+} LFUBucket;
+
+// RS_LFU bookkeeping, only allocated for pools using that strategy
+typedef struct LFUData
+{
+    // non-empty buckets in ascending frequency
+    LFUBucket *lowest;
+    LFUBucket *buckets;
+    LFUBucket *freeBuckets;
+
+    // bucket of each frame (NULL while the frame is empty) and its neighbours there
+    LFUBucket **bucketOf;
+    int *newer;
+    int *older;
+
+    // frequencies are halved every agingInterval pins, 0 turns aging off
+    int agingInterval;
+    int pinsSinceAging;
+} LFUData;
+
+// RS_ARC: list of frames or ghost slots, least recently used first
+typedef struct ARCList
+{
+    int lru;
+    int mru;
+    int size;
+} ARCList;
+
+// RS_ARC bookkeeping, only allocated for pools using that strategy
+typedef struct ARCData
+{
+    int capacity;
+    int target; // adaptive target size p of T1
+
+    // resident pages seen once (T1) and more than once (T2)
+    ARCList t1;
+    ARCList t2;
+    int *framePrev;
+    int *frameNext;
+    ARCList **frameList; // list of each frame, NULL while the frame is empty
+
+    // ghost lists: page numbers recently evicted from T1 (B1) and T2 (B2)
+    ARCList b1;
+    ARCList b2;
+    PageNumber *ghostPage;
+    int *ghostPrev;
+    int *ghostNext;
+    ARCList **ghostList;
+    int freeGhost;
+    PageTable ghostIndex; // page number to ghost slot
+} ARCData;
+
+typedef struct PoolFile PoolFile;
+
+// One partition of the pool: a slice of the frames with its own latch, page table and
+// replacement state. Frame indices are local to the partition.
 typedef struct BPData
 {
     int pageframesavailable;
     int readoperations;
     int writeoperations;
 
-    //  page metadata
-    int *listPageNo;
+    // position in the pool and number of frames
+    int partition;
+    int firstFrame;
+    int numFrames;
+
+    // held while the partition's frames or bookkeeping change
+    pthread_mutex_t latch;
+
+    //  page metadata, slices of the pool-wide arrays
+    PageNumber *listPageNo;
     int *fixcounts;
     bool *dirtyflag;
 
+    // RS_CLOCK: reference bit per frame, set on every pin, and the sweeping hand
+    bool *refbits;
+    int clockHand;
+
     // linked list for BufferPoolFrame
     BufferPoolFrame *headFrame;
     BufferPoolFrame *currentFrame;
     BufferPoolFrame *endFrame;
-    // page data
+    // list node of each frame, indexed by frame
+    BufferPoolFrame **frameNodes;
+
+    // page table: map from page number to frame, at least twice as many slots as frames
+    PageTable pageTable;
+
+    // RS_LRU_K, RS_LFU and RS_ARC state, NULL for other strategies
+    LRUKData *lruk;
+    LFUData *lfu;
+    ARCData *arc;
+
+    // page data, one frame of pageSize bytes per buffer slot
     char *BpoolData;
+    int pageSize;
+
+    // files cached by the pool, the table of the whole pool (see keyFile)
+    PoolFile **files;
+
+    // dirty frames of the whole pool
+    int *numDirty;
 
 } BPData;
 
-// Struct to maintain page access history
-typedef struct PageAccessHistory
+typedef struct PageCleaner PageCleaner;
+
+// Frames, page tables and strategies know the pages of all files of a pool by key: the
+// file id above the low POOL_PAGE_BITS bits, which hold the page number. The keys of
+// file 0 are its page numbers. At most POOL_MAX_FILES files are attached at a time.
+#define POOL_PAGE_BITS BM_PAGE_BITS
+#define POOL_MAX_FILE_ID ((1 << 23) - 1)
+#define POOL_MAX_FILES 256
+
+// The pool behind bm->mgmtData. Pages are spread over the partitions by a hash of the
+// page number, so pins of different pages rarely wait for each other.
+typedef struct BufferPool
 {
-    int *accessTimes; // Store the last K access times
-    int count;        // no. of times the page was accessed
-} PageAccessHistory;
+    int numPartitions;
+    BPData *partitions;
+
+    // cache hits pin without the latch; only for strategies whose hits need no
+    // bookkeeping beyond the CLOCK reference bit (FIFO and CLOCK)
+    bool optimisticPins;
+
+    // frame metadata and page data of all numFrames frames; partition i owns a contiguous
+    // slice. Fix counts and page numbers change atomically; FRAME_CLAIMED marks a frame
+    // that is being loaded or evicted and cannot be pinned.
+    int numFrames;
+    PageNumber *listPageNo;
+    int *fixcounts;
+    bool *dirtyflag;
+    char *BpoolData;
+    int pageSize;
+
+    // BpoolData is an arena of frameBytes mapped for the frames alone (see mapFrames)
+    size_t frameBytes;
+    bool hugePages;
+    bool prefaultFrames;
+
+    // sidecar file the cached pages are saved to at shutdown for a warm restart (NULL if off)
+    char *warmFile;
+
+    // shared/exclusive latch of each frame, taken by pinPageForRead/pinPageForWrite
+    // while the frame is pinned; numFrameLatches of them are initialized
+    pthread_rwlock_t *frameLatches;
+    int numFrameLatches;
+
+    // number of dirty frames, changed atomically under the frame's partition latch,
+    // and the background writer keeping it between its watermarks (NULL if off)
+    int numDirty;
+    PageCleaner *cleaner;
+
+    // reads started by prefetchPages and read-ahead. The engine is created on first
+    // use and driven under prefetchLock; a frame being read is FRAME_CLAIMED until its
+    // completion is collected.
+    pthread_mutex_t prefetchLock;
+    SM_AsyncIO *aio;
+    int prefetchesInFlight;
+    int *prefetchOrder; // eviction order of one partition
+
+    // pages read ahead of a run of consecutive pins (0 means off)
+    int readAhead;
+
+    // files whose pages the pool caches, file id % POOL_MAX_FILES gives the slot. A pool
+    // of its own has just its file, with id 0; a shared pool takes files as they are
+    // attached and detached, under filesLock, and gives every one a new id.
+    bool shared;
+    SM_OpenMode openMode;
+    pthread_mutex_t filesLock;
+    int nextFileId;
+    int numFiles;
+    PoolFile *files[POOL_MAX_FILES];
+} BufferPool;
+
+// A page file cached by a pool; bm->mgmtData points to one. The handle of a pool of its
+// own owns the pool and the file, the handle of a shared pool owns the pool only, and
+// every file attached to a shared pool has a handle of its own.
+struct PoolFile
+{
+    BufferPool *pool;
+    BM_BufferPool *bm; // the handle, whose numPages follows resizes of the pool
+    bool ownsPool;
+    bool hasFile;
+    int id; // file part of the keys of the file's pages
+
+    // page file kept open while the handle exists; reads and writes share fileLock,
+    // growing the file takes it exclusively
+    SM_FileHandle fileHandle;
+    pthread_rwlock_t fileLock;
+
+    // read-ahead: the last page pinned, the length of the run ending there and the end
+    // of the pages read ahead
+    PageNumber lastPinned;
+    int runLength;
+    PageNumber readAheadEnd;
+
+    // what the statistics functions return for a handle of a shared pool
+    PageNumber *frameContents;
+    bool *dirtyFlags;
+    int *fixCounts;
+};
+
+// Frames a sequential scan recycles instead of taking new victims from the pool
+struct BM_ScanRing
+{
+    BM_BufferPool *bm;
+    int size;          // slots per partition
+    int *next;         // slot to recycle next, per partition
+    int *frames;       // frame of each slot, NO_PAGE while the slot is unused
+    PageNumber *pages; // page the ring loaded into that frame
+};
+
+// fix count of a frame that is being loaded or evicted
+#define FRAME_CLAIMED -1
 
-RC ensureCapacity(int numberOfPages, SM_FileHandle *fHandle);
-RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+// size of the huge pages a frame arena is rounded up to
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// background cleaner defaults, in percent of the frames, and its other limits
+#define CLEANER_HIGH_WATERMARK 50
+#define CLEANER_LOW_WATERMARK 25
+#define CLEANER_BATCH 32       // frames written per cleaning round
+#define CLEANER_INTERVAL_MS 50 // longest sleep between checks of the dirty count
+
+// prefetch limits: reads in flight per pool, and consecutive pins that start read-ahead
+#define PREFETCH_QUEUE_DEPTH 32
+#define READ_AHEAD_TRIGGER 4
+
+// Dirty frame waiting to be flushed, ordered by its page key: by file, then page number
+typedef struct FlushEntry
+{
+    PageNumber pageNum; // key
+    int frame; // index over the whole pool
+} FlushEntry;
+
+// What the strategy knows of a cached page, carried over by resizes and warm restarts
+typedef struct FrameState
+{
+    PageNumber pageNum; // key
+    long long freq;     // RS_LFU use count
+    long long count;    // RS_LRU_K: accesses so far, the last K times are kept apart
+    bool refbit;        // RS_CLOCK reference bit
+    bool frequent;      // RS_ARC: in T2
+} FrameState;
+
+// Start of a warm restart sidecar. One FrameState per cached page follows, partition by
+// partition in eviction order, each followed by its K access times if k is not 0.
+typedef struct WarmHeader
+{
+    int magic;
+    int strategy;
+    int k;
+    int numPages;
+    long long clock; // LRU-K time the access times go up to
+} WarmHeader;
+
+#define WARM_MAGIC 0x31575042 // "BPW1"
+#define WARM_MAX_K 64          // a sidecar with a larger K is taken as damaged
+
+// Background writer of a pool: it sleeps until the number of dirty frames reaches
+// highWatermark, then writes dirty unpinned frames from the eviction end of each
+// partition until no more than lowWatermark are left
+struct PageCleaner
+{
+    pthread_t thread;
+    // held by the thread for a whole cleaning round and by forceFlushPool; guards stop
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool stop;
+    int highWatermark;
+    int lowWatermark;
+    int highPercent; // the watermarks in percent of the frames, for resizes
+    int lowPercent;
+    ReplacementStrategy strategy;
+    int nextPartition; // partition the next round starts with
+
+    // scratch space of a round: copies of the frames being written, the pages in
+    // write order (their 'frame' is the index of the copy) and the frame (over the
+    // whole pool) each copy was taken from
+    char *copies;
+    FlushEntry *entries;
+    SM_PageHandle *runPages;
+    int *frames;
+    bool *written; // whether the write of each copy succeeded
+    int *order;    // eviction order of one partition
+};
+
+RC ensureCapacity(PageNumber numberOfPages, SM_FileHandle *fHandle);
 RC closePageFile(SM_FileHandle *fHandle);
-void LRUCachePinPage(BM_BufferPool *bm, BM_PageHandle *page, PageNumber pageNum);
-int LRUpinPageFIFO(BM_BufferPool *bm, BM_PageHandle *page, PageNumber pageNum, SM_FileHandle *fHandle);
+void freeBpData(BPData *bpData, int numPages);
+void LRUCachePinPage(BPData *bpData, PageNumber pageNum);
+PageNumber LRUpinPageFIFO(BPData *bpData, PageNumber pageNum);
 static PageNumber findPageInBuffer(BPData *bpData, PageNumber thepage, int numPages);
 static BufferPoolFrame *firstframefind(BPData *bpData);
-static void dirtypageneeded(BPData *bpData, SM_FileHandle *fileHandle);
-static void updatenewpg(BPData *bpData, PageNumber pageNum);
+static PageNumber CLOCKpinPage(BPData *bpData, PageNumber pageNum);
+static void dirtypageneeded(BPData *bpData, BufferPoolFrame *frame);
+static void updatenewpg(BPData *bpData, BufferPoolFrame *frame, PageNumber pageNum);
 static void reorder(BPData *bpData, BufferPoolFrame *temp);
+static void vacateFrame(BPData *bpData, int frame);
+static bool pageTableInit(PageTable *table, int numEntries);
+static int pageTableLookup(PageTable *table, PageNumber pageNum);
+static void pageTableInsert(PageTable *table, PageNumber pageNum, int frame);
+static void pageTableRemove(PageTable *table, PageNumber pageNum);
+static RC initLRUK(BPData *bpData, int numPages, void *stratData);
+static void freeLRUK(LRUKData *lruk);
+static void LRUKtouch(LRUKData *lruk, int frame);
+static void LRUKunpin(LRUKData *lruk, int frame);
+static void LRUKrestoreHistory(LRUKData *lruk, int frame, PageNumber pageNum);
+static PageNumber LRUKpinPage(BPData *bpData, PageNumber pageNum);
+static RC initLFU(BPData *bpData, int numPages, void *stratData);
+static void freeLFU(LFUData *lfu);
+static void LFUtouch(LFUData *lfu, int frame);
+static void LFUunlinkFrame(LFUData *lfu, int frame);
+static void LFUlinkFrame(LFUData *lfu, int frame, LFUBucket *bucket);
+static LFUBucket *LFUnewBucket(LFUData *lfu, long long freq, LFUBucket *prev);
+static PageNumber LFUpinPage(BPData *bpData, PageNumber pageNum);
+static RC initARC(BPData *bpData, int numPages);
+static void freeARC(ARCData *arc);
+static void ARChit(ARCData *arc, int frame);
+static void ARCadmit(ARCData *arc, int frame, PageNumber pageNum);
+static PageNumber ARCpinPage(BPData *bpData, PageNumber pageNum);
+static void ARCpushLRU(ARCList *list, int *prev, int *next, int node);
+static void ARCunlink(ARCList *list, int *prev, int *next, int node);
+static int ARCreplaceFrame(ARCData *arc, ARCList *ghost, int target, const int *fixcounts);
+static void ARCforget(ARCData *arc, PageNumber pageNum);
+static RC pinPageInternal(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum,
+                          BM_ScanRing *ring);
+static RC pinPageLatched(BM_BufferPool *const bm, BPData *bpData, BM_PageHandle *const page,
+                         const PageNumber key, BM_ScanRing *ring);
+static int takeRingFrame(BPData *bpData, BM_ScanRing *ring, PageNumber pageNum);
+static BPData *partitionOf(BufferPool *pool, PageNumber pageNum);
+static int pageTableLookupShared(PageTable *table, PageNumber pageNum);
+static bool claimFrame(BPData *bpData, int frame);
+static void releasePin(int *fixcount);
+static bool pinCachedPage(BPData *bpData, BM_PageHandle *const page, PageNumber pageNum);
+static bool unpinCachedPage(BPData *bpData, PageNumber pageNum);
+static void freeBufferPool(BufferPool *pool);
+static RC initPool(BM_BufferPool *const bm, const char *const pageFileName, const int numPages,
+                   ReplacementStrategy strategy, void *stratData, const BM_PoolOptions *options);
+static RC openPoolFile(BufferPool *pool, PoolFile *file, const char *const pageFileName, int pageSize);
+static RC allocFileStats(PoolFile *file, int numPages);
+static void freePoolFile(BufferPool *pool, PoolFile *file);
+static RC detachPageFile(BM_BufferPool *const bm, PoolFile *file);
+static RC pinPageLatchingFrame(BM_BufferPool *const bm, BM_PageHandle *const page,
+                               const PageNumber pageNum, BM_PinMode mode);
+static void LRUKheapRemove(LRUKData *lruk, int frame);
+static int compareFlushEntries(const void *a, const void *b);
+static int flushRunLength(const FlushEntry *entries, int start, int count);
+static RC startCleaner(BufferPool *pool, int numPages, ReplacementStrategy strategy,
+                       const BM_PoolOptions *options);
+static void freeCleaner(PageCleaner *cleaner);
+static void *cleanerThread(void *arg);
+static RC stopCleaner(BufferPool *pool, int numPages);
+static void cleanerNoteDirty(BufferPool *pool, int numDirty);
+static int evictionOrder(ReplacementStrategy strategy, BPData *bpData, int *order);
+static RC startPrefetches(BM_BufferPool *const bm, BufferPool *pool, PageNumber firstPage, int count);
+static int collectPrefetches(BufferPool *pool, bool wait);
+static void pollPrefetches(BufferPool *pool);
+static bool prefetchInFlight(BufferPool *pool, BPData *bpData, PageNumber pageNum);
+static void detectSequential(BM_BufferPool *const bm, PoolFile *file, PageNumber pageNum);
+static int partitionSlice(int numPages, int numPartitions, int partition, int *firstFrame);
+static RC initPartitions(BufferPool *pool, int numPartitions, ReplacementStrategy strategy, void *stratData);
+static void freePoolFrames(BufferPool *pool);
+static void drainPrefetches(BufferPool *pool);
+static void setWatermarks(PageCleaner *cleaner, int numFrames);
+static RC writeFlushEntries(BufferPool *pool, FlushEntry *entries, int numDirty, SM_PageHandle *runPages);
+static RC resizeFrames(BM_BufferPool *const bm, BufferPool *pool, int newNumPages);
+static RC growFrameArrays(BufferPool *pool, PoolFile *owner, int numFrames);
+static void takeFrames(BufferPool *to, BufferPool *from);
+static int victimOrder(ReplacementStrategy strategy, BPData *bpData, int *order);
+static void moveFrame(BPData *from, int oldFrame, BPData *to);
+static void frameState(BPData *bpData, int frame, FrameState *state);
+static int admitFrame(BPData *to, const FrameState *state, const long long *times);
+static RC saveWarmPages(BufferPool *pool, ReplacementStrategy strategy);
+static RC loadWarmPages(BufferPool *pool, PoolFile *file, ReplacementStrategy strategy);
 
 /**
- * This Function initalizes the buffer pool, then allocates memory
+ * Returns the memory of a frame in the buffer pool.
  */
-RC initBP(BPData *bpData, int numPages)
+static inline char *frameData(BPData *bpData, int frame)
 {
-    if (bpData == NULL || numPages <= 0)
-    {
-        return RC_NULL_PARAM;
-    }
-
-    // Initialize all pointers to NULL
-    bpData->dirtyflag = NULL;
-    bpData->listPageNo = NULL;
-    bpData->BpoolData = NULL;
-    bpData->fixcounts = NULL;
-
-    // Allocate memory
-    bpData->dirtyflag = (bool *)calloc(numPages, sizeof(bool));
-    bpData->listPageNo = (int *)malloc(numPages * sizeof(int));
-    bpData->BpoolData = (char *)calloc(numPages * PAGE_SIZE, sizeof(char));
-    bpData->fixcounts = (int *)calloc(numPages, sizeof(int));
+    return bpData->BpoolData + (size_t)frame * bpData->pageSize;
+}
 
-    // Check if all allocations were successful
-    if (!bpData->dirtyflag || !bpData->listPageNo || !bpData->BpoolData || !bpData->fixcounts)
-    {
-        // Free any successfully allocated memory
-        free(bpData->dirtyflag);
-        free(bpData->listPageNo);
-        free(bpData->BpoolData);
-        free(bpData->fixcounts);
+// Index over the whole pool of the frame a pinned page handle points into
+static inline int frameOfHandle(BufferPool *pool, BM_PageHandle *const page)
+{
+    return (int)((page->data - pool->BpoolData) / pool->pageSize);
+}
 
-        // Reset all pointers to NULL
-        bpData->dirtyflag = NULL;
-        bpData->listPageNo = NULL;
-        bpData->BpoolData = NULL;
-        bpData->fixcounts = NULL;
+// Pool behind a handle, shared or not
+static inline BufferPool *getBufferPool(BM_BufferPool *const bm)
+{
+    return ((PoolFile *)bm->mgmtData)->pool;
+}
 
-        return RC_MEM_ALLOC_FAILURE;
-    }
+// Key of a page of a file in the file's pool
+static inline PageNumber pageKey(const PoolFile *file, PageNumber pageNum)
+{
+    return ((PageNumber)file->id << POOL_PAGE_BITS) | pageNum;
+}
 
-    // Initialize metadata
-    bpData->pageframesavailable = numPages;
-    bpData->headFrame = NULL;
-    bpData->currentFrame = NULL;
-    bpData->endFrame = NULL;
-    bpData->readoperations = 0;
-    bpData->writeoperations = 0;
+// Page number a key stands for in its file, and the id of the file
+static inline PageNumber keyPage(PageNumber key)
+{
+    return key & (((PageNumber)1 << POOL_PAGE_BITS) - 1);
+}
 
-    // Initialize page numbers and dirty flags
-    for (int index = 0; index < numPages; index++)
-    {
-        bpData->listPageNo[index] = NO_PAGE;
-        // No need to set dirtyflag as calloc initializes it to false (0)
-    }
+static inline int keyFileId(PageNumber key)
+{
+    return (int)(key >> POOL_PAGE_BITS);
+}
 
-    return RC_OK;
+// File of a key. Only pages of attached files are dirty, pinned or being read, so it is
+// only asked about those; a detached file's slot may belong to another file by now.
+static inline PoolFile *keyFile(PoolFile *const *files, PageNumber key)
+{
+    return files[keyFileId(key) % POOL_MAX_FILES];
 }
 
 /**
- * Initializes the buffer pool, then allocates memory. Checks if the page file name exists,
- * whether pool has initialized or not.
+ * Returns the home slot of a page in a page table (Fibonacci hashing).
  */
-RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
-                  const int numPages, ReplacementStrategy strategy,
-                  void *stratData)
+static inline int pageTableSlot(PageTable *table, PageNumber pageNum)
 {
-    // Check if the buffer pool structure and pageFileName are not NULL
-    if (!bm || !pageFileName)
-    {
-        return RC_NULL_PARAM;
-    }
-
-    struct stat buffer;
+    return (int)(((unsigned long long)pageNum * 0x9E3779B97F4A7C15ULL) >> 32) & table->mask;
+}
 
-    // Check if the file specified by pageFileName exists
-    if (stat(pageFileName, &buffer) != 0)
+/**
+ * Allocates an empty page table with at least twice as many slots as entries it will hold.
+ */
+static bool pageTableInit(PageTable *table, int numEntries)
+{
+    int tableSize = 2;
+    while (tableSize < 2 * numEntries)
     {
-        return RC_FILE_NOT_FOUND;
+        tableSize *= 2;
     }
-
-    bm->pageFile = (char *)pageFileName;
-    bm->numPages = numPages;
-    bm->strategy = strategy;
-
-    // Allocate memory for the buffer pool data structure
-    bm->mgmtData = calloc(1, sizeof(BPData));
-    BPData *bm_bpData = (BPData *)bm->mgmtData;
-
-    // Check if the allocation for the buffer pool data structure is successful
-    if (!bm_bpData)
+    table->entries = (PageTableEntry *)malloc(tableSize * sizeof(PageTableEntry));
+    table->mask = tableSize - 1;
+    if (table->entries == NULL)
     {
-        return RC_MEM_ALLOC_FAILURE;
+        return false;
     }
-    if (initBP(bm_bpData, numPages) != RC_OK)
+    for (int slot = 0; slot < tableSize; slot++)
     {
-        free(bm_bpData); // Clean up on failure
-        return RC_MEM_ALLOC_FAILURE;
+        table->entries[slot].pageNum = NO_PAGE;
     }
-    return RC_OK;
+    return true;
 }
 
 /**
- * Checks for pinned pages
+ * Returns the frame holding a page, or NO_PAGE if the page is not in the table.
  */
-bool hasPinnedPages(const BPData *bpData, int numPages)
+static int pageTableLookup(PageTable *table, PageNumber pageNum)
 {
-    for (int index = 0; index < numPages; index++)
+    for (int slot = pageTableSlot(table, pageNum);; slot = (slot + 1) & table->mask)
     {
-        if (bpData->fixcounts[index] > 0)
+        PageTableEntry *entry = &table->entries[slot];
+        if (entry->pageNum == pageNum)
         {
-            return true; // Found pinned page
+            return entry->frame;
+        }
+        if (entry->pageNum == NO_PAGE)
+        {
+            return NO_PAGE;
         }
     }
-    return false; // none found
 }
 
 /**
- * Frees all allocated memory for the buffer pool data.
+ * Probes a page table without holding its partition's latch. Concurrent changes may make
+ * the probe miss a page or return a frame that no longer holds it, so callers check the
+ * frame afterwards and fall back to the latched path.
  */
-void freeBpData(BPData *bpData)
+static int pageTableLookupShared(PageTable *table, PageNumber pageNum)
 {
-    free(bpData->listPageNo);
-    free(bpData->fixcounts);
-    free(bpData->BpoolData);
-    free(bpData->dirtyflag);
-
-    // Reset pointers to NULL after freeing
-    bpData->listPageNo = NULL;
-    bpData->BpoolData = NULL;
-    bpData->dirtyflag = NULL;
-
-    // Reset linked list pointers
-    bpData->headFrame = NULL;
-    bpData->currentFrame = NULL;
-    bpData->endFrame = NULL;
+    int slot = pageTableSlot(table, pageNum);
+    for (int probes = 0; probes <= table->mask; probes++, slot = (slot + 1) & table->mask)
+    {
+        PageNumber entryPage = __atomic_load_n(&table->entries[slot].pageNum, __ATOMIC_ACQUIRE);
+        if (entryPage == pageNum)
+        {
+            return __atomic_load_n(&table->entries[slot].frame, __ATOMIC_RELAXED);
+        }
+        if (entryPage == NO_PAGE)
+        {
+            break;
+        }
+    }
+    return NO_PAGE;
+}
 
-    // Reset operation counters
-    bpData->readoperations = 0;
-    bpData->writeoperations = 0;
+// Entries are published frame first, so a shared probe never sees a page without a frame
+static inline void pageTableStore(PageTableEntry *entry, PageNumber pageNum, int frame)
+{
+    __atomic_store_n(&entry->frame, frame, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->pageNum, pageNum, __ATOMIC_RELEASE);
 }
 
 /**
- * Shut down buffer pool and flush dirty pages
+ * Records that a page was loaded into a frame.
  */
-RC shutdownBufferPool(BM_BufferPool *const bm)
+static void pageTableInsert(PageTable *table, PageNumber pageNum, int frame)
 {
-    if (!bm)
-    {
-        return RC_BUFFER_POOL_NOT_EXIST;
-    }
-
-    BPData *bpData = (BPData *)bm->mgmtData;
-    if (!bpData)
-    {
-        return RC_BUFFER_POOL_DATA_NOT_EXIST;
-    }
-
-    if (hasPinnedPages(bpData, bm->numPages))
+    int slot = pageTableSlot(table, pageNum);
+    while (table->entries[slot].pageNum != NO_PAGE && table->entries[slot].pageNum != pageNum)
     {
-        return RC_SHUTDOWN_POOL_ERROR;
+        slot = (slot + 1) & table->mask;
     }
-
-    forceFlushPool(bm);
-    freeBpData(bpData);
-    free(bm->mgmtData);
-    bm->mgmtData = NULL;
-
-    return RC_OK;
+    pageTableStore(&table->entries[slot], pageNum, frame);
 }
 
 /**
- * Forcecully flush the buffer pool, write all dirty pages by iterating over each page in the buffer pool.
- * If dirty and not fixed, write to disk. If not, reset the dirty flag.
+ * Drops an evicted page from a page table. Later entries of the probe chain are
+ * shifted back into the hole, so lookups never need tombstones.
  */
-RC forceFlushPool(BM_BufferPool *const bm)
+static void pageTableRemove(PageTable *table, PageNumber pageNum)
 {
-    SM_FileHandle fileHandle;
-    int status = openPageFile(bm->pageFile, &fileHandle);
-
-    if (status != RC_OK)
+    int mask = table->mask;
+    int hole = pageTableSlot(table, pageNum);
+    while (table->entries[hole].pageNum != pageNum)
     {
-        return RC_FILE_NOT_FOUND;
+        if (table->entries[hole].pageNum == NO_PAGE)
+        {
+            return; // not in the table
+        }
+        hole = (hole + 1) & mask;
     }
 
-    BPData *bpData = (BPData *)bm->mgmtData;
-
-    // Iterate over each page in the buffer pool
-    for (PageNumber pageNumber = 0; pageNumber < bm->numPages; pageNumber++)
+    for (int slot = (hole + 1) & mask; table->entries[slot].pageNum != NO_PAGE; slot = (slot + 1) & mask)
     {
-        // Check if the page is dirty (has been modified) and not fixed (pinned)
-        if (bpData->dirtyflag[pageNumber] && bpData->fixcounts[pageNumber] == 0)
+        // an entry may fill the hole if its home slot does not lie in (hole, slot]
+        int home = pageTableSlot(table, table->entries[slot].pageNum);
+        if (((slot - home) & mask) >= ((slot - hole) & mask))
         {
-            SM_PageHandle pageHandle = bpData->BpoolData + pageNumber * PAGE_SIZE * sizeof(char);
-            int actualPageIndex = bpData->listPageNo[pageNumber];
-            writeBlock(actualPageIndex, &fileHandle, pageHandle);
-            bpData->dirtyflag[pageNumber] = false;
-            bpData->writeoperations++;
+            pageTableStore(&table->entries[hole], table->entries[slot].pageNum, table->entries[slot].frame);
+            hole = slot;
         }
     }
-
-    // Close page file
-    return closePageFile(&fileHandle);
+    __atomic_store_n(&table->entries[hole].pageNum, NO_PAGE, __ATOMIC_RELEASE);
 }
 
 /**
- * Mark page in buffer pool as dirty. The function takes the buffer pool, points to the page handle struct and the page no.
- * then returns a success code if found.
+ * Returns the partition a page belongs to. The partition is taken from the top bits of
+ * the page's hash; page tables use the low ones, so pages still spread over their slots.
  */
-RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page)
+static BPData *partitionOf(BufferPool *pool, PageNumber pageNum)
 {
-    /* Checks if the buffer pool or page handle is NULL. */
-    if (bm == NULL || page == NULL)
+    unsigned long long hash = ((unsigned long long)pageNum * 0x9E3779B97F4A7C15ULL) >> 32;
+    return &pool->partitions[(hash * pool->numPartitions) >> 32];
+}
+
+/*
+ Maps the frame arena of a pool: anonymous memory, zeroed and page aligned, so frames can
+ be handed to O_DIRECT reads and writes as they are. With hugePages the arena comes from
+ the system's reserved huge pages if it has enough, otherwise from regular pages the
+ kernel is asked to back with transparent huge pages; either way a large pool needs far
+ fewer TLB entries. prefault touches every page up front, so first pins do not fault.
+ Sets *mappedBytes to the size to unmap; returns NULL if nothing could be mapped.
+ */
+static char *mapFrames(size_t size, bool hugePages, bool prefault, size_t *mappedBytes)
+{
+    void *arena = MAP_FAILED;
+    if (hugePages)
     {
-        return RC_PAGE_NOT_FOUND_IN_CACHE;
+        *mappedBytes = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        arena = mmap(NULL, *mappedBytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (prefault ? MAP_POPULATE : 0), -1, 0);
     }
-    BPData *bpData = (BPData *)bm->mgmtData;
-    PageNumber tgtPage = page->pageNum;
-
-    /* Find the page number in the buffer pool. */
-    PageNumber bufferPoolPageNumber = findPageInBuffer(bpData, tgtPage, bm->numPages);
-
-    if (bufferPoolPageNumber == NO_PAGE)
+    if (arena == MAP_FAILED)
     {
-        return RC_PAGE_NOT_FOUND_IN_CACHE;
+        *mappedBytes = size;
+        arena = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (arena == MAP_FAILED)
+        {
+            return NULL;
+        }
+        if (hugePages)
+        {
+            madvise(arena, size, MADV_HUGEPAGE); // only a hint, pools work without it
+        }
+        // a write, as reading would only map the shared zero page
+        for (size_t offset = 0; prefault && offset < size; offset += PAGE_SIZE)
+        {
+            ((volatile char *)arena)[offset] = 0;
+        }
     }
-
-    bpData->dirtyflag[bufferPoolPageNumber] = true;
-    return RC_OK;
+    return (char *)arena;
 }
 
 /**
- * The function looks for a page number in the buffer pool, takes the buffer pool data structure, the targer page no.,
- * the total no. of pages, and returns the index of the pool where the page is found. or NO_PAGE if not found.
+ * Allocates the frames and frame metadata of the whole pool.
  */
-static PageNumber findPageInBuffer(BPData *bpdta, PageNumber thepage, int numPages)
+static RC initPoolFrames(BufferPool *pool, int numPages, int pageSize)
 {
-    BufferPoolFrame *thisPage = bpdta->headFrame;
+    pool->dirtyflag = (bool *)calloc(numPages, sizeof(bool));
+    pool->listPageNo = (PageNumber *)malloc(numPages * sizeof(PageNumber));
+    pool->BpoolData = mapFrames((size_t)numPages * pageSize, pool->hugePages, pool->prefaultFrames,
+                                &pool->frameBytes);
+    pool->fixcounts = (int *)calloc(numPages, sizeof(int));
+    pool->frameLatches = (pthread_rwlock_t *)malloc(numPages * sizeof(pthread_rwlock_t));
+    pool->numFrames = numPages;
+    pool->pageSize = pageSize;
 
-    // Calculate the number of filled slots in the buffer pool
-    int fullslots = numPages - bpdta->pageframesavailable;
+    // Check if all allocations were successful
+    if (!pool->dirtyflag || !pool->listPageNo || !pool->BpoolData || !pool->fixcounts || !pool->frameLatches)
+    {
+        return RC_MEM_ALLOC_FAILURE;
+    }
+    for (; pool->numFrameLatches < numPages; pool->numFrameLatches++)
+    {
+        pthread_rwlock_init(&pool->frameLatches[pool->numFrameLatches], NULL);
+    }
 
-    // Traverse the linked list
-    for (int i = 0; i < fullslots && thisPage != NULL; i++)
+    // Initialize page numbers; calloc already cleared the dirty flags and fix counts
+    for (int index = 0; index < numPages; index++)
     {
-        if (thisPage->indexpage == thepage)
-        {
-            return thisPage->indexpool;
-        }
-        thisPage = thisPage->nextFrame;
+        pool->listPageNo[index] = NO_PAGE;
     }
-    return NO_PAGE;
+    return RC_OK;
 }
 
 /**
- * This function is used to unpin a page in the buffer pool. When a page is unpinned,
- * its fix count is decremented by 1. If the fix count of the page becomes 0, it means
- * that the page is no longer fixed and can be evicted from the buffer pool if necessary.
+ * This Function initalizes one partition of the buffer pool: frames firstFrame to
+ * firstFrame + numFrames - 1 of 'pool'. Partial allocations are released by freeBpData.
  */
-RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
+RC initBP(BPData *bpData, BufferPool *pool, int partition, int firstFrame, int numFrames)
 {
-    if (bm == NULL || page == NULL)
+    if (bpData == NULL || pool == NULL || numFrames <= 0)
     {
-        return RC_PAGE_NOT_FOUND_IN_CACHE;
+        return RC_NULL_PARAM;
     }
 
-    PageNumber tgtPage = page->pageNum;
-    BPData *bpData = (BPData *)bm->mgmtData;
+    // Slices of the pool-wide arrays
+    bpData->listPageNo = pool->listPageNo + firstFrame;
+    bpData->fixcounts = pool->fixcounts + firstFrame;
+    bpData->dirtyflag = pool->dirtyflag + firstFrame;
+    bpData->BpoolData = pool->BpoolData + (size_t)firstFrame * pool->pageSize;
+    bpData->pageSize = pool->pageSize;
+    bpData->files = pool->files;
+    bpData->numDirty = &pool->numDirty;
 
-    PageNumber bufferPoolPageNumber = findPageInBuffer(bpData, tgtPage, bm->numPages);
+    // Initialize metadata
+    bpData->partition = partition;
+    bpData->firstFrame = firstFrame;
+    bpData->numFrames = numFrames;
+    bpData->pageframesavailable = numFrames;
+    bpData->headFrame = NULL;
+    bpData->currentFrame = NULL;
+    bpData->endFrame = NULL;
+    bpData->clockHand = 0;
+    bpData->readoperations = 0;
+    bpData->writeoperations = 0;
+    bpData->lruk = NULL;
+    bpData->lfu = NULL;
+    bpData->arc = NULL;
+    pthread_mutex_init(&bpData->latch, NULL);
 
-    if (bufferPoolPageNumber == NO_PAGE)
-    {
-        return RC_PAGE_NOT_FOUND_IN_CACHE;
-    }
+    // Allocate memory
+    bpData->frameNodes = (BufferPoolFrame **)calloc(numFrames, sizeof(BufferPoolFrame *));
+    bpData->refbits = (bool *)calloc(numFrames, sizeof(bool));
+    pageTableInit(&bpData->pageTable, numFrames);
 
-    if (bpData->fixcounts[bufferPoolPageNumber] > 0)
+    // Check if all allocations were successful
+    if (!bpData->frameNodes || !bpData->pageTable.entries || !bpData->refbits)
     {
-        bpData->fixcounts[bufferPoolPageNumber]--;
+        return RC_MEM_ALLOC_FAILURE;
     }
-
     return RC_OK;
 }
 
 /**
- * This function writes a page to disk by opening the page file, writing the page data
- * to disk using the page file and the actual page number, and then closing the page file.
+ * Initializes the buffer pool, then allocates memory. Checks if the page file name exists,
+ * whether pool has initialized or not.
  */
-RC writePageToFile(const char *pageFile, PageNumber pageNum, SM_PageHandle pageHandle)
+RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
+                  const int numPages, ReplacementStrategy strategy,
+                  void *stratData)
 {
-    // Open the page file for writing
-    SM_FileHandle fileHandle;
-    char *mutablePageFile = strdup(pageFile);
-    if (mutablePageFile == NULL)
+    return initBufferPoolWithOptions(bm, pageFileName, numPages, strategy, stratData, NULL);
+}
+
+/**
+ * Same as initBufferPool, with optional settings such as direct I/O on the page file or
+ * the number of partitions.
+ */
+RC initBufferPoolWithOptions(BM_BufferPool *const bm, const char *const pageFileName,
+                             const int numPages, ReplacementStrategy strategy,
+                             void *stratData, const BM_PoolOptions *options)
+{
+    // Check if the buffer pool structure and pageFileName are not NULL
+    if (!bm || !pageFileName)
+    {
+        return RC_NULL_PARAM;
+    }
+    return initPool(bm, pageFileName, numPages, strategy, stratData, options);
+}
+
+/**
+ * Initializes a buffer pool that caches pages of many page files, which are attached to it
+ * with attachPageFile. Its frames take PAGE_SIZE byte pages.
+ */
+RC initSharedBufferPool(BM_BufferPool *const bm, const int numPages, ReplacementStrategy strategy,
+                        void *stratData, const BM_PoolOptions *options)
+{
+    if (!bm)
+    {
+        return RC_NULL_PARAM;
+    }
+    return initPool(bm, NULL, numPages, strategy, stratData, options);
+}
+
+/*
+ Shared body of initBufferPoolWithOptions and initSharedBufferPool; pageFileName is NULL
+ for a shared pool.
+ */
+static RC initPool(BM_BufferPool *const bm, const char *const pageFileName, const int numPages,
+                   ReplacementStrategy strategy, void *stratData, const BM_PoolOptions *options)
+{
+    if (numPages <= 0)
+    {
+        return RC_ERROR;
+    }
+
+    // Every partition needs at least one frame
+    int numPartitions = (options != NULL && options->numPartitions > 1) ? options->numPartitions : 1;
+    if (numPartitions > numPages)
+    {
+        return RC_ERROR;
+    }
+
+    // A warm restart finds its pages by page number, which only a pool of its own keeps
+    if (options != NULL && options->warmRestart && pageFileName == NULL)
+    {
+        return RC_ERROR;
+    }
+
+    // The cleaner writes down to the low watermark once the high one is reached
+    if (options != NULL && options->backgroundCleaner)
+    {
+        int high = options->dirtyHighWatermark > 0 ? options->dirtyHighWatermark : CLEANER_HIGH_WATERMARK;
+        int low = options->dirtyLowWatermark > 0 ? options->dirtyLowWatermark : CLEANER_LOW_WATERMARK;
+        if (high > 100 || low >= high)
+        {
+            return RC_ERROR;
+        }
+    }
+
+    bm->pageFile = (char *)pageFileName;
+    bm->numPages = numPages;
+    bm->strategy = strategy;
+
+    // Allocate memory for the buffer pool data structure and the handle owning it
+    BufferPool *pool = (BufferPool *)calloc(1, sizeof(BufferPool));
+    PoolFile *file = (PoolFile *)calloc(1, sizeof(PoolFile));
+    bm->mgmtData = file;
+
+    // Check if the allocation for the buffer pool data structure is successful
+    if (!pool || !file)
+    {
+        free(pool);
+        free(file);
+        bm->mgmtData = NULL;
+        return RC_MEM_ALLOC_FAILURE;
+    }
+    file->pool = pool;
+    file->bm = bm;
+    file->ownsPool = true;
+    pool->shared = pageFileName == NULL;
+    pool->optimisticPins = strategy == RS_FIFO || strategy == RS_CLOCK;
+    pthread_mutex_init(&pool->prefetchLock, NULL);
+    pthread_mutex_init(&pool->filesLock, NULL);
+    pool->readAhead = (options != NULL && options->readAheadPages > 0) ? options->readAheadPages : 0;
+    pool->openMode = (options != NULL && options->directIO) ? SM_MODE_DIRECT : SM_MODE_PREAD;
+    pool->hugePages = options != NULL && options->hugePages;
+    pool->prefaultFrames = options != NULL && options->prefaultFrames;
+
+    // Open the page file once; every pin, flush and eviction reuses this handle. Frames
+    // take the page size the file was created with.
+    RC rc = RC_OK;
+    if (pageFileName != NULL)
+    {
+        rc = openPoolFile(pool, file, pageFileName, 0);
+    }
+    if (rc == RC_OK)
+    {
+        rc = initPoolFrames(pool, numPages, file->hasFile ? file->fileHandle.pageSize : PAGE_SIZE);
+    }
+    if (rc == RC_OK && pool->shared)
+    {
+        rc = allocFileStats(file, numPages);
+    }
+    if (rc == RC_OK)
+    {
+        rc = initPartitions(pool, numPartitions, strategy, stratData);
+    }
+
+    // Reload the pages the last shutdown saved; if that fails the pool starts cold
+    if (rc == RC_OK && options != NULL && options->warmRestart)
+    {
+        pool->warmFile = (char *)malloc(strlen(pageFileName) + sizeof(".warm"));
+        rc = pool->warmFile != NULL ? RC_OK : RC_MEM_ALLOC_FAILURE;
+        if (rc == RC_OK)
+        {
+            sprintf(pool->warmFile, "%s.warm", pageFileName);
+        }
+        if (rc == RC_OK && loadWarmPages(pool, file, strategy) != RC_OK)
+        {
+            freePoolFrames(pool);
+            rc = initPoolFrames(pool, numPages, file->fileHandle.pageSize);
+            if (rc == RC_OK)
+            {
+                rc = initPartitions(pool, numPartitions, strategy, stratData);
+            }
+        }
+    }
+    if (rc == RC_OK && options != NULL && options->backgroundCleaner)
+    {
+        rc = startCleaner(pool, numPages, strategy, options);
+    }
+    if (rc != RC_OK)
+    {
+        freePoolFile(pool, file);
+        freeBufferPool(pool);
+        free(pool);
+        bm->mgmtData = NULL;
+        return rc;
+    }
+    return RC_OK;
+}
+
+/*
+ Number of frames of a partition when numPages frames are split into numPartitions as
+ evenly as possible, the first partitions taking the remainder; sets its first frame.
+ */
+static int partitionSlice(int numPages, int numPartitions, int partition, int *firstFrame)
+{
+    int remainder = numPages % numPartitions;
+    *firstFrame = partition * (numPages / numPartitions) + (partition < remainder ? partition : remainder);
+    return numPages / numPartitions + (partition < remainder ? 1 : 0);
+}
+
+/*
+ Splits the frames of a pool into partitions and sets up the strategy of each. Partial
+ allocations are released by freePoolFrames.
+ */
+static RC initPartitions(BufferPool *pool, int numPartitions, ReplacementStrategy strategy, void *stratData)
+{
+    pool->partitions = (BPData *)calloc(numPartitions, sizeof(BPData));
+    if (pool->partitions == NULL)
+    {
+        return RC_MEM_ALLOC_FAILURE;
+    }
+
+    RC rc = RC_OK;
+    for (int partition = 0; rc == RC_OK && partition < numPartitions; partition++)
+    {
+        BPData *bpData = &pool->partitions[partition];
+        int firstFrame;
+        int numFrames = partitionSlice(pool->numFrames, numPartitions, partition, &firstFrame);
+        rc = initBP(bpData, pool, partition, firstFrame, numFrames);
+        pool->numPartitions = partition + 1;
+
+        // Strategies with their own bookkeeping
+        if (rc != RC_OK)
+        {
+            break;
+        }
+        if (strategy == RS_LRU_K)
+        {
+            rc = initLRUK(bpData, numFrames, stratData);
+        }
+        else if (strategy == RS_LFU)
+        {
+            rc = initLFU(bpData, numFrames, stratData);
+        }
+        else if (strategy == RS_ARC)
+        {
+            rc = initARC(bpData, numFrames);
+        }
+    }
+    return rc;
+}
+
+/**
+ * Attaches a page file to a shared pool. 'bm' becomes a handle of the file that the other
+ * functions of the buffer manager take like a pool of its own, but its pages go into the
+ * frames of 'sharedPool', next to the pages of the other files. shutdownBufferPool(bm)
+ * detaches the file again. The file must use the pool's page size.
+ */
+RC attachPageFile(BM_BufferPool *const bm, BM_BufferPool *const sharedPool, const char *const pageFileName)
+{
+    if (!bm || !sharedPool || !sharedPool->mgmtData || !pageFileName)
+    {
+        return RC_NULL_PARAM;
+    }
+    BufferPool *pool = getBufferPool(sharedPool);
+    if (!pool->shared)
+    {
+        return RC_ERROR; // a pool of its own caches its one file only
+    }
+
+    PoolFile *file = (PoolFile *)calloc(1, sizeof(PoolFile));
+    if (file == NULL)
+    {
+        return RC_MEM_ALLOC_FAILURE;
+    }
+    file->pool = pool;
+    file->bm = bm;
+    RC rc = allocFileStats(file, pool->numFrames);
+    if (rc == RC_OK)
+    {
+        rc = openPoolFile(pool, file, pageFileName, pool->pageSize);
+    }
+    if (rc != RC_OK)
+    {
+        freePoolFile(pool, file);
+        bm->mgmtData = NULL;
+        return rc;
+    }
+
+    bm->pageFile = (char *)pageFileName;
+    bm->numPages = pool->numFrames;
+    bm->strategy = sharedPool->strategy;
+    bm->mgmtData = file;
+    return RC_OK;
+}
+
+/*
+ Opens a page file of a pool and enters it in the pool's file table under the next free
+ id. A file whose page size differs from pageSize is refused, unless pageSize is 0.
+ */
+static RC openPoolFile(BufferPool *pool, PoolFile *file, const char *const pageFileName, int pageSize)
+{
+    if (openPageFileMode((char *)pageFileName, &file->fileHandle, pool->openMode) != RC_OK)
+    {
+        return RC_FILE_NOT_FOUND;
+    }
+    if (pageSize != 0 && file->fileHandle.pageSize != pageSize)
+    {
+        closePageFile(&file->fileHandle);
+        return RC_ERROR;
+    }
+
+    // ids are never given out twice, so a page a detached file left behind in a frame
+    // never matches a page of a file attached later
+    pthread_mutex_lock(&pool->filesLock);
+    int id = pool->nextFileId;
+    while (pool->numFiles < POOL_MAX_FILES && pool->files[id % POOL_MAX_FILES] != NULL)
+    {
+        id++;
+    }
+    if (pool->numFiles == POOL_MAX_FILES || id > POOL_MAX_FILE_ID)
+    {
+        pthread_mutex_unlock(&pool->filesLock);
+        closePageFile(&file->fileHandle);
+        return RC_ERROR;
+    }
+    pool->files[id % POOL_MAX_FILES] = file;
+    pool->nextFileId = id + 1;
+    pool->numFiles++;
+    pthread_mutex_unlock(&pool->filesLock);
+
+    file->id = id;
+    file->hasFile = true;
+    file->lastPinned = NO_PAGE;
+    pthread_rwlock_init(&file->fileLock, NULL);
+    return RC_OK;
+}
+
+// Allocates, or enlarges, the arrays the statistics functions return for a handle of a
+// shared pool
+static RC allocFileStats(PoolFile *file, int numPages)
+{
+    PageNumber *frameContents = (PageNumber *)realloc(file->frameContents, numPages * sizeof(PageNumber));
+    file->frameContents = frameContents != NULL ? frameContents : file->frameContents;
+    bool *dirtyFlags = (bool *)realloc(file->dirtyFlags, numPages * sizeof(bool));
+    file->dirtyFlags = dirtyFlags != NULL ? dirtyFlags : file->dirtyFlags;
+    int *fixCounts = (int *)realloc(file->fixCounts, numPages * sizeof(int));
+    file->fixCounts = fixCounts != NULL ? fixCounts : file->fixCounts;
+    if (!frameContents || !dirtyFlags || !fixCounts)
+    {
+        return RC_MEM_ALLOC_FAILURE;
+    }
+    return RC_OK;
+}
+
+/*
+ Closes the page file of a handle, drops it from the pool's file table and frees the
+ handle.
+ */
+static void freePoolFile(BufferPool *pool, PoolFile *file)
+{
+    if (file->hasFile)
+    {
+        pthread_mutex_lock(&pool->filesLock);
+        pool->files[file->id % POOL_MAX_FILES] = NULL;
+        pool->numFiles--;
+        pthread_mutex_unlock(&pool->filesLock);
+        closePageFile(&file->fileHandle);
+        pthread_rwlock_destroy(&file->fileLock);
+    }
+    free(file->frameContents);
+    free(file->dirtyFlags);
+    free(file->fixCounts);
+    free(file);
+}
+
+/**
+ * Checks for pinned pages, only those of 'file' unless it is NULL
+ */
+bool hasPinnedPages(const BufferPool *pool, int numPages, const PoolFile *file)
+{
+    for (int index = 0; index < numPages; index++)
+    {
+        if (__atomic_load_n(&pool->fixcounts[index], __ATOMIC_RELAXED) > 0 &&
+            (file == NULL || keyFileId(__atomic_load_n(&pool->listPageNo[index], __ATOMIC_ACQUIRE)) == file->id))
+        {
+            return true; // Found pinned page
+        }
+    }
+    return false; // none found
+}
+
+/**
+ * Frees all allocated memory of one partition of the buffer pool.
+ */
+void freeBpData(BPData *bpData, int numPages)
+{
+    if (bpData->frameNodes != NULL)
+    {
+        for (int frame = 0; frame < numPages; frame++)
+        {
+            free(bpData->frameNodes[frame]);
+        }
+    }
+    free(bpData->frameNodes);
+    free(bpData->pageTable.entries);
+    free(bpData->refbits);
+    freeLRUK(bpData->lruk);
+    freeLFU(bpData->lfu);
+    freeARC(bpData->arc);
+    pthread_mutex_destroy(&bpData->latch);
+
+    // Reset pointers to NULL after freeing
+    bpData->listPageNo = NULL;
+    bpData->BpoolData = NULL;
+    bpData->dirtyflag = NULL;
+    bpData->fixcounts = NULL;
+    bpData->frameNodes = NULL;
+    bpData->pageTable.entries = NULL;
+    bpData->refbits = NULL;
+    bpData->lruk = NULL;
+    bpData->lfu = NULL;
+    bpData->arc = NULL;
+
+    // Reset linked list pointers
+    bpData->headFrame = NULL;
+    bpData->currentFrame = NULL;
+    bpData->endFrame = NULL;
+
+    // Reset operation counters
+    bpData->readoperations = 0;
+    bpData->writeoperations = 0;
+}
+
+/**
+ * Frees the partitions and frames of the buffer pool.
+ */
+static void freePoolFrames(BufferPool *pool)
+{
+    for (int partition = 0; partition < pool->numPartitions; partition++)
+    {
+        freeBpData(&pool->partitions[partition], pool->partitions[partition].numFrames);
+    }
+    free(pool->partitions);
+    free(pool->listPageNo);
+    free(pool->fixcounts);
+    if (pool->BpoolData != NULL)
+    {
+        munmap(pool->BpoolData, pool->frameBytes);
+    }
+    free(pool->dirtyflag);
+    for (int frame = 0; frame < pool->numFrameLatches; frame++)
+    {
+        pthread_rwlock_destroy(&pool->frameLatches[frame]);
+    }
+    free(pool->frameLatches);
+
+    pool->partitions = NULL;
+    pool->numPartitions = 0;
+    pool->numFrames = 0;
+    pool->listPageNo = NULL;
+    pool->fixcounts = NULL;
+    pool->BpoolData = NULL;
+    pool->frameBytes = 0;
+    pool->dirtyflag = NULL;
+    pool->frameLatches = NULL;
+    pool->numFrameLatches = 0;
+}
+
+/**
+ * Frees everything the buffer pool holds. Its files must be closed already.
+ */
+static void freeBufferPool(BufferPool *pool)
+{
+    freePoolFrames(pool);
+    pthread_mutex_destroy(&pool->filesLock);
+    if (pool->aio != NULL)
+    {
+        shutdownAsyncIO(pool->aio);
+    }
+    free(pool->prefetchOrder);
+    pthread_mutex_destroy(&pool->prefetchLock);
+    free(pool->warmFile);
+
+    pool->aio = NULL;
+    pool->prefetchOrder = NULL;
+    pool->warmFile = NULL;
+}
+
+/**
+ * Shut down buffer pool and flush dirty pages. No other thread may use the pool anymore.
+ * With the warmRestart option the cached pages are saved for the next start first.
+ * For a file attached to a shared pool only the file is detached: its dirty pages are
+ * flushed and it is closed, while the pool keeps running. A shared pool cannot be shut
+ * down before all of its files are detached.
+ */
+RC shutdownBufferPool(BM_BufferPool *const bm)
+{
+    if (!bm)
+    {
+        return RC_BUFFER_POOL_NOT_EXIST;
+    }
+
+    PoolFile *file = (PoolFile *)bm->mgmtData;
+    if (!file)
+    {
+        return RC_BUFFER_POOL_DATA_NOT_EXIST;
+    }
+    BufferPool *pool = file->pool;
+    drainPrefetches(pool);
+
+    if (!file->ownsPool)
+    {
+        return detachPageFile(bm, file);
+    }
+    pthread_mutex_lock(&pool->filesLock);
+    bool attached = pool->shared && pool->numFiles > 0;
+    pthread_mutex_unlock(&pool->filesLock);
+    if (attached || stopCleaner(pool, pool->numFrames) != RC_OK)
+    {
+        return RC_SHUTDOWN_POOL_ERROR;
+    }
+
+    forceFlushPool(bm);
+    if (pool->warmFile != NULL)
+    {
+        saveWarmPages(pool, bm->strategy); // without a sidecar the next start is just cold
+    }
+    freePoolFile(pool, file);
+    freeBufferPool(pool);
+    free(pool);
+    bm->mgmtData = NULL;
+
+    return RC_OK;
+}
+
+/*
+ Detaches a file from its shared pool, unless pages of it are still pinned. Its dirty
+ pages are written before it is closed; the clean ones stay in their frames until they
+ are evicted, under a key no later file can have.
+ */
+static RC detachPageFile(BM_BufferPool *const bm, PoolFile *file)
+{
+    BufferPool *pool = file->pool;
+
+    // a cleaning round holds pins of its own
+    if (pool->cleaner != NULL)
+    {
+        pthread_mutex_lock(&pool->cleaner->lock);
+    }
+    bool pinned = hasPinnedPages(pool, pool->numFrames, file);
+    if (pool->cleaner != NULL)
+    {
+        pthread_mutex_unlock(&pool->cleaner->lock);
+    }
+    if (pinned)
+    {
+        return RC_SHUTDOWN_POOL_ERROR;
+    }
+
+    RC rc = forceFlushPool(bm);
+    if (rc != RC_OK)
+    {
+        return rc;
+    }
+    freePoolFile(pool, file);
+    bm->mgmtData = NULL;
+    return RC_OK;
+}
+
+/**
+ * Resizes the pool without a restart. Only the handle that created it may do this, while
+ * no page is pinned and no other thread uses the pool.
+ */
+RC resizeBufferPool(BM_BufferPool *const bm, const int newNumPages)
+{
+    if (!bm || !bm->mgmtData)
+    {
+        return RC_NULL_PARAM;
+    }
+    PoolFile *file = (PoolFile *)bm->mgmtData;
+    BufferPool *pool = file->pool;
+    if (!file->ownsPool || newNumPages < pool->numPartitions)
+    {
+        return RC_ERROR; // every partition keeps at least one frame
+    }
+    if (newNumPages == pool->numFrames)
+    {
+        return RC_OK;
+    }
+    drainPrefetches(pool);
+
+    // the cleaner stays out for the whole resize; its pins are only held during a round
+    if (pool->cleaner != NULL)
+    {
+        pthread_mutex_lock(&pool->cleaner->lock);
+    }
+    RC rc = hasPinnedPages(pool, pool->numFrames, NULL) ? RC_POOL_HAS_PINNED_PAGES
+                                                        : growFrameArrays(pool, file, newNumPages);
+    if (rc == RC_OK)
+    {
+        rc = resizeFrames(bm, pool, newNumPages);
+    }
+    if (pool->cleaner != NULL)
+    {
+        pthread_mutex_unlock(&pool->cleaner->lock);
+    }
+    return rc;
+}
+
+/*
+ Moves the pages of a pool into newNumPages frames. The partitions stay as many, so every
+ page stays in its partition. Each ranks its pages in the order its strategy would evict
+ them and keeps the last ones, as many as its new slice has frames. The dirty pages it
+ drops are written first, so a failed write leaves the pool as it was. The kept pages
+ then move to new frames together with their recency, frequency or history; only ARC's
+ ghost lists and the histories LRU-K retained for evicted pages start over.
+ */
+static RC resizeFrames(BM_BufferPool *const bm, BufferPool *pool, int newNumPages)
+{
+    int numPartitions = pool->numPartitions;
+    int *order = (int *)malloc(pool->numFrames * sizeof(int));
+    int *counts = (int *)malloc(numPartitions * sizeof(int));
+    FlushEntry *entries = (FlushEntry *)malloc(pool->numFrames * sizeof(FlushEntry));
+    SM_PageHandle *runPages = (SM_PageHandle *)malloc(pool->numFrames * sizeof(SM_PageHandle));
+    RC rc = (order && counts && entries && runPages) ? RC_OK : RC_MEM_ALLOC_FAILURE;
+
+    // Rank the pages of every partition, in its slice of 'order', and write the dirty ones
+    // that do not fit
+    int numDirty = 0;
+    for (int partition = 0; rc == RC_OK && partition < numPartitions; partition++)
+    {
+        BPData *bpData = &pool->partitions[partition];
+        int *ranked = order + bpData->firstFrame;
+        int firstFrame;
+        int numFrames = partitionSlice(newNumPages, numPartitions, partition, &firstFrame);
+        counts[partition] = victimOrder(bm->strategy, bpData, ranked);
+        for (int pos = 0; pos < counts[partition] - numFrames; pos++)
+        {
+            if (bpData->dirtyflag[ranked[pos]])
+            {
+                entries[numDirty].pageNum = bpData->listPageNo[ranked[pos]];
+                entries[numDirty].frame = bpData->firstFrame + ranked[pos];
+                numDirty++;
+            }
+        }
+    }
+    if (rc == RC_OK)
+    {
+        rc = writeFlushEntries(pool, entries, numDirty, runPages);
+    }
+
+    // Set up the new frames and partitions next to the old ones; K and the aging interval
+    // carry over
+    BufferPool old;
+    memset(&old, 0, sizeof(BufferPool));
+    int setting = pool->partitions[0].lruk != NULL  ? pool->partitions[0].lruk->k
+                  : pool->partitions[0].lfu != NULL ? pool->partitions[0].lfu->agingInterval
+                                                    : 0;
+    if (rc == RC_OK)
+    {
+        takeFrames(&old, pool);
+        rc = initPoolFrames(pool, newNumPages, old.pageSize);
+        if (rc == RC_OK)
+        {
+            rc = initPartitions(pool, numPartitions, bm->strategy, &setting);
+        }
+        if (rc != RC_OK)
+        {
+            freePoolFrames(pool);
+            takeFrames(pool, &old);
+        }
+    }
+
+    // Move the kept pages over, the one to be evicted first first
+    for (int partition = 0; rc == RC_OK && partition < numPartitions; partition++)
+    {
+        BPData *from = &old.partitions[partition];
+        BPData *to = &pool->partitions[partition];
+        int *ranked = order + from->firstFrame;
+        for (int pos = counts[partition] > to->numFrames ? counts[partition] - to->numFrames : 0;
+             pos < counts[partition]; pos++)
+        {
+            moveFrame(from, ranked[pos], to);
+        }
+        to->readoperations = from->readoperations;
+        to->writeoperations = from->writeoperations;
+        if (to->lruk != NULL)
+        {
+            to->lruk->clock = from->lruk->clock;
+        }
+        else if (to->lfu != NULL)
+        {
+            to->lfu->pinsSinceAging = from->lfu->pinsSinceAging;
+        }
+        else if (to->arc != NULL)
+        {
+            // scaled in long long: target * capacity overflows an int in pools of 100k frames
+            long long target = (long long)from->arc->target * to->arc->capacity / from->arc->capacity;
+            to->arc->target = (int)(target < 0 ? 0 : target > to->arc->capacity ? to->arc->capacity : target);
+        }
+    }
+
+    if (rc == RC_OK)
+    {
+        freePoolFrames(&old);
+        if (pool->cleaner != NULL)
+        {
+            setWatermarks(pool->cleaner, newNumPages);
+        }
+        pthread_mutex_lock(&pool->filesLock);
+        for (int slot = 0; slot < POOL_MAX_FILES; slot++)
+        {
+            if (pool->files[slot] != NULL)
+            {
+                pool->files[slot]->bm->numPages = newNumPages;
+            }
+        }
+        pthread_mutex_unlock(&pool->filesLock);
+        bm->numPages = newNumPages;
+    }
+    free(order);
+    free(counts);
+    free(entries);
+    free(runPages);
+    return rc;
+}
+
+/*
+ Enlarges the arrays sized by the number of frames before a pool grows to numFrames: the
+ scratch orders of the cleaner and of prefetching, which take the first partition, and
+ the statistics arrays of the handles. When the pool shrinks they are left as they are.
+ */
+static RC growFrameArrays(BufferPool *pool, PoolFile *owner, int numFrames)
+{
+    if (numFrames <= pool->numFrames)
+    {
+        return RC_OK;
+    }
+    int firstFrame;
+    size_t orderSize = partitionSlice(numFrames, pool->numPartitions, 0, &firstFrame) * sizeof(int);
+    if (pool->cleaner != NULL)
+    {
+        int *order = (int *)realloc(pool->cleaner->order, orderSize);
+        if (order == NULL)
+        {
+            return RC_MEM_ALLOC_FAILURE;
+        }
+        pool->cleaner->order = order;
+    }
+    if (pool->prefetchOrder != NULL)
+    {
+        int *order = (int *)realloc(pool->prefetchOrder, orderSize);
+        if (order == NULL)
+        {
+            return RC_MEM_ALLOC_FAILURE;
+        }
+        pool->prefetchOrder = order;
+    }
+
+    // the handle of a shared pool is not in the file table
+    RC rc = owner->frameContents != NULL ? allocFileStats(owner, numFrames) : RC_OK;
+    pthread_mutex_lock(&pool->filesLock);
+    for (int slot = 0; rc == RC_OK && slot < POOL_MAX_FILES; slot++)
+    {
+        if (pool->files[slot] != NULL && pool->files[slot]->frameContents != NULL)
+        {
+            rc = allocFileStats(pool->files[slot], numFrames);
+        }
+    }
+    pthread_mutex_unlock(&pool->filesLock);
+    return rc;
+}
+
+// Hands the frames and partitions of one pool over to another, leaving 'from' without any
+static void takeFrames(BufferPool *to, BufferPool *from)
+{
+    to->numPartitions = from->numPartitions;
+    to->partitions = from->partitions;
+    to->numFrames = from->numFrames;
+    to->listPageNo = from->listPageNo;
+    to->fixcounts = from->fixcounts;
+    to->dirtyflag = from->dirtyflag;
+    to->BpoolData = from->BpoolData;
+    to->frameBytes = from->frameBytes;
+    to->pageSize = from->pageSize;
+    to->frameLatches = from->frameLatches;
+    to->numFrameLatches = from->numFrameLatches;
+
+    from->numPartitions = 0;
+    from->partitions = NULL;
+    from->numFrames = 0;
+    from->listPageNo = NULL;
+    from->fixcounts = NULL;
+    from->dirtyflag = NULL;
+    from->BpoolData = NULL;
+    from->frameBytes = 0;
+    from->frameLatches = NULL;
+    from->numFrameLatches = 0;
+}
+
+/*
+ Writes the page numbers cached in a pool of its own to its warm restart sidecar, with
+ what the strategy knows of each page. The data stays in the page file; loadWarmPages
+ reads it from there. A sidecar that could not be written completely is removed.
+ */
+static RC saveWarmPages(BufferPool *pool, ReplacementStrategy strategy)
+{
+    int *order = (int *)malloc(pool->partitions[0].numFrames * sizeof(int));
+    FILE *sidecar = order != NULL ? fopen(pool->warmFile, "wb") : NULL;
+    if (sidecar == NULL)
+    {
+        free(order);
+        return RC_WRITE_FAILED;
+    }
+
+    WarmHeader header = {WARM_MAGIC, strategy, 0, 0, 0};
+    header.k = pool->partitions[0].lruk != NULL ? pool->partitions[0].lruk->k : 0;
+    bool written = fwrite(&header, sizeof(WarmHeader), 1, sidecar) == 1;
+    for (int partition = 0; written && partition < pool->numPartitions; partition++)
+    {
+        BPData *bpData = &pool->partitions[partition];
+        int count = victimOrder(strategy, bpData, order);
+        for (int pos = 0; written && pos < count; pos++)
+        {
+            FrameState state;
+            frameState(bpData, order[pos], &state);
+            written = fwrite(&state, sizeof(FrameState), 1, sidecar) == 1 &&
+                      (header.k == 0 || fwrite(bpData->lruk->history[order[pos]].accessTimes, sizeof(long long),
+                                               header.k, sidecar) == (size_t)header.k);
+        }
+        header.numPages += count;
+        if (bpData->lruk != NULL && bpData->lruk->clock > header.clock)
+        {
+            header.clock = bpData->lruk->clock;
+        }
+    }
+
+    // the header goes in again with the final count
+    written = written && fseek(sidecar, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(WarmHeader), 1, sidecar) == 1;
+    written = fclose(sidecar) == 0 && written;
+    free(order);
+    if (!written)
+    {
+        remove(pool->warmFile);
+        return RC_WRITE_FAILED;
+    }
+    return RC_OK;
+}
+
+/*
+ Reloads the pages listed in the warm restart sidecar of a new, empty pool of its own.
+ Every partition takes the pages that hash to it, the last listed first, as they are the
+ ones its strategy valued most, until its frames are full; the records are read from the
+ end, so no more of them are held than the pool has frames. The strategy gets back what
+ it knew of them if the saved pool used the same one (and the same K). The data is read
+ from the page file sorted, one readBlocks per run of consecutive pages, so a warm start
+ costs a few large reads. Without a sidecar, or with one whose header does not match its
+ size, the pool simply starts cold; a failed read of the page file returns an error, and
+ the caller has to reset the frames.
+ */
+static RC loadWarmPages(BufferPool *pool, PoolFile *file, ReplacementStrategy strategy)
+{
+    FILE *sidecar = fopen(pool->warmFile, "rb");
+    if (sidecar == NULL)
+    {
+        return RC_OK;
+    }
+    WarmHeader header;
+    struct stat sidecarStat;
+    bool valid = fread(&header, sizeof(WarmHeader), 1, sidecar) == 1 && fstat(fileno(sidecar), &sidecarStat) == 0 &&
+                 header.magic == WARM_MAGIC && header.numPages >= 0 &&
+                 header.strategy >= RS_FIFO && header.strategy <= RS_ARC &&
+                 (header.strategy == RS_LRU_K ? header.k >= 1 && header.k <= WARM_MAX_K : header.k == 0);
+    size_t recordSize = valid ? sizeof(FrameState) + (size_t)header.k * sizeof(long long) : 0;
+    if (!valid || (unsigned long long)sidecarStat.st_size !=
+                      sizeof(WarmHeader) + (unsigned long long)header.numPages * recordSize)
+    {
+        fclose(sidecar);
+        return RC_OK;
+    }
+    LRUKData *lruk = pool->partitions[0].lruk;
+    bool sameStrategy = header.strategy == (int)strategy && (lruk == NULL || header.k == lruk->k);
+
+    int numFrames = pool->numFrames;
+    FrameState *states = (FrameState *)malloc((size_t)numFrames * sizeof(FrameState));
+    long long *times = (long long *)malloc(((size_t)numFrames * header.k + 1) * sizeof(long long));
+    int *kept = (int *)calloc(pool->numPartitions, sizeof(int));
+    FlushEntry *entries = (FlushEntry *)malloc((size_t)numFrames * sizeof(FlushEntry));
+    SM_PageHandle *runPages = (SM_PageHandle *)malloc((size_t)numFrames * sizeof(SM_PageHandle));
+    RC rc = (states && times && kept && entries && runPages) ? RC_OK : RC_MEM_ALLOC_FAILURE;
+
+    // Each partition keeps the last pages listed for it that still exist; they are filed
+    // from the back of states, which leaves them in the order listed
+    int numKept = 0;
+    bool damaged = false;
+    for (int i = header.numPages - 1; rc == RC_OK && !damaged && i >= 0 && numKept < numFrames; i--)
+    {
+        int slot = numFrames - 1 - numKept;
+        damaged = fseeko(sidecar, (off_t)(sizeof(WarmHeader) + (size_t)i * recordSize), SEEK_SET) != 0 ||
+                  fread(&states[slot], sizeof(FrameState), 1, sidecar) != 1 ||
+                  fread(times + (size_t)slot * header.k, sizeof(long long), header.k, sidecar) != (size_t)header.k;
+        PageNumber pageNum = states[slot].pageNum;
+        if (damaged || pageNum < 0 || pageNum >= file->fileHandle.totalNumPages)
+        {
+            continue;
+        }
+        BPData *bpData = partitionOf(pool, pageNum);
+        if (kept[bpData->partition] < bpData->numFrames)
+        {
+            kept[bpData->partition]++;
+            numKept++;
+        }
+    }
+    fclose(sidecar);
+
+    // Map them to frames in the order listed, which is their eviction order
+    int numLoaded = 0;
+    for (int slot = numFrames - numKept; rc == RC_OK && !damaged && slot < numFrames; slot++)
+    {
+        BPData *bpData = partitionOf(pool, states[slot].pageNum);
+        if (pageTableLookup(&bpData->pageTable, states[slot].pageNum) != NO_PAGE)
+        {
+            continue;
+        }
+        if (!sameStrategy)
+        {
+            states[slot].freq = 1;
+            states[slot].refbit = false;
+            states[slot].frequent = false;
+        }
+        int frame = admitFrame(bpData, &states[slot],
+                               sameStrategy && header.k > 0 ? times + (size_t)slot * header.k : NULL);
+        entries[numLoaded].pageNum = states[slot].pageNum;
+        entries[numLoaded].frame = bpData->firstFrame + frame;
+        numLoaded++;
+        bpData->readoperations++;
+        if (sameStrategy && bpData->lruk != NULL && bpData->lruk->clock < header.clock)
+        {
+            bpData->lruk->clock = header.clock;
+        }
+    }
+
+    // Read the pages in runs of consecutive page numbers
+    if (rc == RC_OK)
+    {
+        qsort(entries, numLoaded, sizeof(FlushEntry), compareFlushEntries);
+    }
+    for (int start = 0; rc == RC_OK && start < numLoaded;)
+    {
+        int runLength = flushRunLength(entries, start, numLoaded);
+        for (int i = 0; i < runLength; i++)
+        {
+            runPages[i] = pool->BpoolData + (size_t)entries[start + i].frame * pool->pageSize;
+        }
+        rc = readBlocks(keyPage(entries[start].pageNum), runLength, &file->fileHandle, runPages);
+        start += runLength;
+    }
+
+    free(states);
+    free(times);
+    free(kept);
+    free(entries);
+    free(runPages);
+    return rc;
+}
+
+static int compareFlushEntries(const void *a, const void *b)
+{
+    PageNumber left = ((const FlushEntry *)a)->pageNum;
+    PageNumber right = ((const FlushEntry *)b)->pageNum;
+    return (left > right) - (left < right);
+}
+
+/*
+ Length of the run of consecutive pages of one file starting at entries[start], of
+ 'count' entries sorted by compareFlushEntries.
+ */
+static int flushRunLength(const FlushEntry *entries, int start, int count)
+{
+    int runLength = 1;
+    while (start + runLength < count &&
+           entries[start + runLength].pageNum == entries[start].pageNum + runLength &&
+           keyFileId(entries[start + runLength].pageNum) == keyFileId(entries[start].pageNum))
+    {
+        runLength++;
+    }
+    return runLength;
+}
+
+/**
+ * Forcecully flush the buffer pool, write all dirty pages that are not fixed to disk.
+ * Dirty frames are sorted by page number so each run of consecutive pages goes out
+ * with a single writeBlocks call. All partitions are latched, in order, for the flush.
+ * The handle of a file attached to a shared pool flushes the pages of that file only.
+ */
+RC forceFlushPool(BM_BufferPool *const bm)
+{
+    PoolFile *file = (PoolFile *)bm->mgmtData;
+    if (file == NULL)
+    {
+        return RC_BUFFER_POOL_DATA_NOT_EXIST;
+    }
+    BufferPool *pool = file->pool;
+    const PoolFile *only = file->ownsPool ? NULL : file;
+
+    FlushEntry *entries = malloc(pool->numFrames * sizeof(FlushEntry));
+    SM_PageHandle *runPages = malloc(pool->numFrames * sizeof(SM_PageHandle));
+    if (entries == NULL || runPages == NULL)
+    {
+        free(entries);
+        free(runPages);
+        return RC_MEM_ALLOC_FAILURE;
+    }
+
+    // no cleaning round may have frames pinned or writes in flight during the flush
+    if (pool->cleaner != NULL)
+    {
+        pthread_mutex_lock(&pool->cleaner->lock);
+    }
+    for (int partition = 0; partition < pool->numPartitions; partition++)
+    {
+        pthread_mutex_lock(&pool->partitions[partition].latch);
+    }
+
+    // Collect pages that are dirty (have been modified) and not fixed (pinned)
+    int numDirty = 0;
+    for (int frame = 0; frame < pool->numFrames; frame++)
+    {
+        if (pool->dirtyflag[frame] && __atomic_load_n(&pool->fixcounts[frame], __ATOMIC_RELAXED) == 0 &&
+            (only == NULL || keyFileId(pool->listPageNo[frame]) == only->id))
+        {
+            entries[numDirty].pageNum = pool->listPageNo[frame];
+            entries[numDirty].frame = frame;
+            numDirty++;
+        }
+    }
+    RC status = writeFlushEntries(pool, entries, numDirty, runPages);
+
+    for (int partition = pool->numPartitions - 1; partition >= 0; partition--)
+    {
+        pthread_mutex_unlock(&pool->partitions[partition].latch);
+    }
+    if (pool->cleaner != NULL)
+    {
+        pthread_mutex_unlock(&pool->cleaner->lock);
+    }
+
+    free(entries);
+    free(runPages);
+    return status;
+}
+
+/*
+ Writes the dirty frames of 'entries' in runs of consecutive pages and marks them clean,
+ sorting the entries first; runPages has room for all of them. Returns the error of the
+ last failed write, the frames of that run stay dirty.
+ */
+static RC writeFlushEntries(BufferPool *pool, FlushEntry *entries, int numDirty, SM_PageHandle *runPages)
+{
+    qsort(entries, numDirty, sizeof(FlushEntry), compareFlushEntries);
+
+    RC status = RC_OK;
+    for (int start = 0; start < numDirty;)
+    {
+        // Extend the run while page numbers stay consecutive
+        int runLength = flushRunLength(entries, start, numDirty);
+
+        for (int i = 0; i < runLength; i++)
+        {
+            runPages[i] = pool->BpoolData + (size_t)entries[start + i].frame * pool->pageSize;
+        }
+        PoolFile *runFile = keyFile(pool->files, entries[start].pageNum);
+        pthread_rwlock_rdlock(&runFile->fileLock);
+        RC rc = writeBlocks(keyPage(entries[start].pageNum), runLength, &runFile->fileHandle, runPages);
+        pthread_rwlock_unlock(&runFile->fileLock);
+        if (rc != RC_OK)
+        {
+            status = rc;
+        }
+        else
+        {
+            for (int i = 0; i < runLength; i++)
+            {
+                pool->dirtyflag[entries[start + i].frame] = false;
+                __atomic_sub_fetch(&pool->numDirty, 1, __ATOMIC_RELAXED);
+                partitionOf(pool, entries[start + i].pageNum)->writeoperations++;
+            }
+        }
+        start += runLength;
+    }
+    return status;
+}
+
+/**
+ * Mark page in buffer pool as dirty. The function takes the buffer pool, points to the page handle struct and the page no.
+ * then returns a success code if found.
+ */
+RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    /* Checks if the buffer pool or page handle is NULL. */
+    if (bm == NULL || page == NULL)
+    {
+        return RC_PAGE_NOT_FOUND_IN_CACHE;
+    }
+    /* Readers share the frame, so they must not change it. */
+    if (page->mode == PIN_READ)
+    {
+        return RC_PAGE_PINNED_FOR_READ;
+    }
+    PageNumber tgtPage = pageKey((PoolFile *)bm->mgmtData, page->pageNum);
+    BufferPool *pool = getBufferPool(bm);
+    BPData *bpData = partitionOf(pool, tgtPage);
+    int numDirty = 0;
+    pthread_mutex_lock(&bpData->latch);
+
+    /* Find the page number in the buffer pool. */
+    PageNumber bufferPoolPageNumber = findPageInBuffer(bpData, tgtPage, bpData->numFrames);
+
+    if (bufferPoolPageNumber != NO_PAGE && !bpData->dirtyflag[bufferPoolPageNumber])
+    {
+        bpData->dirtyflag[bufferPoolPageNumber] = true;
+        numDirty = __atomic_add_fetch(bpData->numDirty, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&bpData->latch);
+    if (numDirty > 0)
+    {
+        cleanerNoteDirty(pool, numDirty);
+    }
+    return bufferPoolPageNumber == NO_PAGE ? RC_PAGE_NOT_FOUND_IN_CACHE : RC_OK;
+}
+
+/**
+ * The function looks for a page number in the buffer pool, takes the buffer pool data structure, the targer page no.,
+ * the total no. of pages, and returns the index of the pool where the page is found. or NO_PAGE if not found.
+ * The lookup goes through the page table, so it takes constant time whatever the pool size.
+ */
+static PageNumber findPageInBuffer(BPData *bpdta, PageNumber thepage, int numPages)
+{
+    return pageTableLookup(&bpdta->pageTable, thepage);
+}
+
+/**
+ * This function is used to unpin a page in the buffer pool. When a page is unpinned,
+ * its fix count is decremented by 1. If the fix count of the page becomes 0, it means
+ * that the page is no longer fixed and can be evicted from the buffer pool if necessary.
+ * A frame latch taken by pinPageForRead or pinPageForWrite is released first, while the
+ * pin still keeps the frame in place.
+ */
+RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    if (bm == NULL || page == NULL)
+    {
+        return RC_PAGE_NOT_FOUND_IN_CACHE;
+    }
+
+    PageNumber tgtPage = pageKey((PoolFile *)bm->mgmtData, page->pageNum);
+    BufferPool *pool = getBufferPool(bm);
+    BPData *bpData = partitionOf(pool, tgtPage);
+    if (page->mode != PIN_NONE)
+    {
+        pthread_rwlock_unlock(&pool->frameLatches[frameOfHandle(pool, page)]);
+        page->mode = PIN_NONE;
+    }
+    if (pool->optimisticPins && unpinCachedPage(bpData, tgtPage))
+    {
+        return RC_OK;
+    }
+    pthread_mutex_lock(&bpData->latch);
+
+    PageNumber bufferPoolPageNumber = findPageInBuffer(bpData, tgtPage, bpData->numFrames);
+
+    if (bufferPoolPageNumber == NO_PAGE)
+    {
+        pthread_mutex_unlock(&bpData->latch);
+        return RC_PAGE_NOT_FOUND_IN_CACHE;
+    }
+
+    releasePin(&bpData->fixcounts[bufferPoolPageNumber]);
+    if (bpData->lruk != NULL && bpData->fixcounts[bufferPoolPageNumber] == 0)
+    {
+        LRUKunpin(bpData->lruk, bufferPoolPageNumber);
+    }
+
+    pthread_mutex_unlock(&bpData->latch);
+    return RC_OK;
+}
+
+/**
+ * This function writes a page to disk through the pool's open file handle
+ * using the actual page number.
+ */
+RC writePageToFile(SM_FileHandle *fileHandle, PageNumber pageNum, SM_PageHandle pageHandle)
+{
+    // Write the page data to the file using the page file and the actual page number
+    return writeBlock(pageNum, fileHandle, pageHandle);
+}
+
+/**
+ * This writes the page data to disk and marks the page as no longer dirty.
+ * If the page is found, it writes the page data to disk using the page file and the actual page no.
+ * Then, it resets the dirty flag for the page in the buffer pool data and increments the write op counter.
+ * Then returns the success RC_OK code.
+ */
+RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    // Get the actual page number from the page handle, and its key in the pool
+    PoolFile *file = (PoolFile *)bm->mgmtData;
+    PageNumber actualPageNumber = page->pageNum;
+    PageNumber key = pageKey(file, actualPageNumber);
+    // Get the partition holding the page
+    BPData *bpData = partitionOf(file->pool, key);
+    pthread_mutex_lock(&bpData->latch);
+    // Find the index of the page in the buffer pool
+    PageNumber bufferPoolPageNumber = findPageInBuffer(bpData, key, bpData->numFrames);
+
+    if (bufferPoolPageNumber == NO_PAGE)
+    {
+        pthread_mutex_unlock(&bpData->latch);
+        return RC_PAGE_NOT_FOUND_IN_CACHE;
+    }
+    pthread_rwlock_rdlock(&file->fileLock);
+    RC status = writePageToFile(&file->fileHandle, actualPageNumber, page->data);
+    pthread_rwlock_unlock(&file->fileLock);
+    if (status == RC_OK)
+    {
+        // Mark the page as not dirty
+        if (bpData->dirtyflag[bufferPoolPageNumber])
+        {
+            __atomic_sub_fetch(bpData->numDirty, 1, __ATOMIC_RELAXED);
+        }
+        bpData->dirtyflag[bufferPoolPageNumber] = false;
+        // Increment write operations counter
+        bpData->writeoperations++;
+    }
+    pthread_mutex_unlock(&bpData->latch);
+    return status;
+}
+
+/*
+ Key of the page in a frame of a shared pool if the handle 'file' reports it, NO_PAGE
+ otherwise: a file's handle reports the file's pages, the pool's own handle those of all
+ attached files. The caller holds filesLock.
+ */
+static PageNumber reportedKey(BufferPool *pool, const PoolFile *file, int frame)
+{
+    PageNumber key = __atomic_load_n(&pool->listPageNo[frame], __ATOMIC_ACQUIRE);
+    if (key == NO_PAGE)
+    {
+        return NO_PAGE;
+    }
+    if (file->hasFile)
+    {
+        return keyFileId(key) == file->id ? key : NO_PAGE;
+    }
+    PoolFile *owner = keyFile(pool->files, key);
+    return owner != NULL && owner->id == keyFileId(key) ? key : NO_PAGE;
+}
+
+/**
+ * Returns an array of PageNumber containing the page numbers of all the frames in the buffer pool.
+ * For a shared pool, frames holding pages the handle does not report show NO_PAGE.
+ */
+PageNumber *getFrameContents(BM_BufferPool *const bm)
+{
+    PoolFile *file = (PoolFile *)bm->mgmtData;
+    BufferPool *pool = file->pool;
+    if (!pool->shared)
+    {
+        return pool->listPageNo;
+    }
+    pthread_mutex_lock(&pool->filesLock);
+    for (int frame = 0; frame < pool->numFrames; frame++)
+    {
+        PageNumber key = reportedKey(pool, file, frame);
+        file->frameContents[frame] = key == NO_PAGE ? NO_PAGE : keyPage(key);
+    }
+    pthread_mutex_unlock(&pool->filesLock);
+    return file->frameContents;
+}
+
+/**
+ * Returns an array of of bools that indicate whether each page in the buffer pool is dirty or not.
+ */
+bool *getDirtyFlags(BM_BufferPool *const bm)
+{
+    PoolFile *file = (PoolFile *)bm->mgmtData;
+    BufferPool *pool = file->pool;
+    if (!pool->shared)
+    {
+        return pool->dirtyflag;
+    }
+    pthread_mutex_lock(&pool->filesLock);
+    for (int frame = 0; frame < pool->numFrames; frame++)
+    {
+        file->dirtyFlags[frame] = reportedKey(pool, file, frame) != NO_PAGE && pool->dirtyflag[frame];
+    }
+    pthread_mutex_unlock(&pool->filesLock);
+    return file->dirtyFlags;
+}
+
+/**
+ * Returns an array of integers showing the number of times each page in the buffer pool
+ * has been fixed
+ */
+int *getFixCounts(BM_BufferPool *const bm)
+{
+    PoolFile *file = (PoolFile *)bm->mgmtData;
+    BufferPool *pool = file->pool;
+    if (!pool->shared)
+    {
+        return pool->fixcounts;
+    }
+    pthread_mutex_lock(&pool->filesLock);
+    for (int frame = 0; frame < pool->numFrames; frame++)
+    {
+        file->fixCounts[frame] = reportedKey(pool, file, frame) != NO_PAGE
+                                     ? __atomic_load_n(&pool->fixcounts[frame], __ATOMIC_RELAXED)
+                                     : 0;
+    }
+    pthread_mutex_unlock(&pool->filesLock);
+    return file->fixCounts;
+}
+
+/**
+ * Returns the size in bytes of the pages (and frames) of the buffer pool's page file.
+ */
+int getPoolPageSize(BM_BufferPool *const bm)
+{
+    return getBufferPool(bm)->pageSize;
+}
+
+/**
+ * Returns the number of read I/O operations performed by the buffer pool, for a shared
+ * pool those of all its files.
+ */
+int getNumReadIO(BM_BufferPool *const bm)
+{
+    BufferPool *pool = getBufferPool(bm);
+    int total = 0;
+    for (int partition = 0; partition < pool->numPartitions; partition++)
+    {
+        BPData *bpData = &pool->partitions[partition];
+        pthread_mutex_lock(&bpData->latch);
+        total += bpData->readoperations;
+        pthread_mutex_unlock(&bpData->latch);
+    }
+    return total;
+}
+
+/**
+ * Returns the number of write I/O operations performed by the buffer pool, for a shared
+ * pool those of all its files. A write operation is performed whenever a page is written to disk.
+ */
+int getNumWriteIO(BM_BufferPool *const bm)
+{
+    BufferPool *pool = getBufferPool(bm);
+    int total = 0;
+    for (int partition = 0; partition < pool->numPartitions; partition++)
+    {
+        BPData *bpData = &pool->partitions[partition];
+        pthread_mutex_lock(&bpData->latch);
+        total += bpData->writeoperations;
+        pthread_mutex_unlock(&bpData->latch);
+    }
+    return total;
+}
+
+/**
+ * Finds the page number of a page in the cache.
+ */
+static bool findPageInCache(BPData *bpd, PageNumber pageNum, PageNumber *pgindexbp)
+{
+    int frame = pageTableLookup(&bpd->pageTable, pageNum);
+    if (frame == NO_PAGE)
+    {
+        return false;
+    }
+    *pgindexbp = frame;
+    return true;
+}
+
+/**
+ * Adds a new frame to the cache.
+ */
+static void addNewFrameToCache(BPData *bpData, PageNumber pageNum, PageNumber pgIndexBP)
+{
+    BufferPoolFrame *handle = malloc(sizeof(BufferPoolFrame));
+    handle->indexpool = pgIndexBP;
+    handle->indexpage = pageNum;
+    handle->nextFrame = NULL;
+
+    if (bpData->headFrame == NULL)
+    {
+        bpData->headFrame = bpData->endFrame = handle;
+        handle->prevFrame = NULL;
+    }
+    else
+    {
+        bpData->endFrame->nextFrame = handle;
+        handle->prevFrame = bpData->endFrame;
+        bpData->endFrame = handle;
+    }
+
+    bpData->frameNodes[pgIndexBP] = handle;
+    // nobody may pin the frame before its page is read
+    bpData->fixcounts[pgIndexBP] = FRAME_CLAIMED;
+    __atomic_store_n(&bpData->listPageNo[pgIndexBP], pageNum, __ATOMIC_RELEASE);
+    pageTableInsert(&bpData->pageTable, pageNum, pgIndexBP);
+    bpData->pageframesavailable--;
+}
+
+/**
+ * This function handles a page that is already in the cache. It changes the page's fix count
+ * and points the page handle to the correct page in the cache.
+ */
+void handleCachedPage(BM_BufferPool *const bm, BM_PageHandle *const page, PageNumber pgIndexBP, const PageNumber pageNum, BPData *bpData)
+{
+    if (bm->strategy == RS_LRU)
+    {
+        LRUCachePinPage(bpData, pageNum); // Use pageNum here as well
+    }
+    page->data = frameData(bpData, pgIndexBP);
+    __atomic_add_fetch(&bpData->fixcounts[pgIndexBP], 1, __ATOMIC_ACQ_REL);
+}
+
+/**
+ * This function determines which frame of a partition should be replaced when a new page is requested.
+ * It currently supports the FIFO, LRU, CLOCK, LRU-K, LFU and ARC strategies.
+ */
+PageNumber selectPageReplacementFrame(BM_BufferPool *const bm, BPData *bpData, const PageNumber pageNum)
+{
+    if (bm->strategy == RS_FIFO || bm->strategy == RS_LRU)
+    {
+        return LRUpinPageFIFO(bpData, pageNum);
+    }
+    else if (bm->strategy == RS_CLOCK)
+    {
+        return CLOCKpinPage(bpData, pageNum);
+    }
+    else if (bm->strategy == RS_LRU_K)
+    {
+        return LRUKpinPage(bpData, pageNum);
+    }
+    else if (bm->strategy == RS_LFU)
+    {
+        return LFUpinPage(bpData, pageNum);
+    }
+    else if (bm->strategy == RS_ARC)
+    {
+        return ARCpinPage(bpData, pageNum);
+    }
+    else
+    {
+        printf("\n \n \t \t \t \t \t \t Other Page Replacement Strategies are not available\n");
+        return NO_PAGE; // Return a default value if no strategy is available
+    }
+}
+
+/**
+ * This function gets a page from the buffer pool for the given page number. If the page is already there,
+ * it brings it to front. If not, it selects a new frame and that page is read from disk to the frame.
+ * The frame is then added to the cache.
+ */
+RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+{
+    // Check for null pointers
+    if (bm == NULL || page == NULL)
+    {
+        return RC_NULL_PARAM; // Define this error code as needed
+    }
+    return pinPageInternal(bm, page, pageNum, NULL);
+}
+
+/**
+ * Pins a page and latches its frame shared. Readers of the same page share the frame
+ * and its single read from disk; they wait only for a writer.
+ */
+RC pinPageForRead(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+{
+    return pinPageLatchingFrame(bm, page, pageNum, PIN_READ);
+}
+
+/**
+ * Pins a page and latches its frame exclusively, waiting for the pins of other readers
+ * and writers of the page to be released.
+ */
+RC pinPageForWrite(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+{
+    return pinPageLatchingFrame(bm, page, pageNum, PIN_WRITE);
+}
+
+/*
+ Shared body of pinPageForRead and pinPageForWrite. The frame latch is taken after the pin
+ and outside the partition latch: the pin keeps the frame from being evicted, and a pinner
+ waiting for a writer does not hold up the rest of the partition.
+ */
+static RC pinPageLatchingFrame(BM_BufferPool *const bm, BM_PageHandle *const page,
+                               const PageNumber pageNum, BM_PinMode mode)
+{
+    if (bm == NULL || page == NULL)
+    {
+        return RC_NULL_PARAM;
+    }
+    RC rc = pinPageInternal(bm, page, pageNum, NULL);
+    if (rc != RC_OK)
+    {
+        return rc;
+    }
+    BufferPool *pool = getBufferPool(bm);
+    pthread_rwlock_t *latch = &pool->frameLatches[frameOfHandle(pool, page)];
+    if (mode == PIN_WRITE)
+    {
+        pthread_rwlock_wrlock(latch);
+    }
+    else
+    {
+        pthread_rwlock_rdlock(latch);
+    }
+    page->mode = mode;
+    return RC_OK;
+}
+
+/**
+ * Pins a page for a sequential scan. A page that is already in the pool is pinned as usual,
+ * a missing one is read into the next frame of the ring, so the scan never pushes more
+ * than the ring's frames out of the pool.
+ */
+RC pinPageWithRing(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum,
+                   BM_ScanRing *ring)
+{
+    if (bm == NULL || page == NULL || ring == NULL)
+    {
+        return RC_NULL_PARAM;
+    }
+    if (ring->bm != bm)
+    {
+        return RC_ERROR;
+    }
+    return pinPageInternal(bm, page, pageNum, ring);
+}
+
+/*
+ Creates a ring for sequential scans of 'bm'. The ring takes up to numFrames frames of each
+ partition, capped at an eighth of the partition (at least one frame), which leaves the
+ rest of the pool to the other users.
+ */
+RC createScanRing(BM_BufferPool *const bm, int numFrames, BM_ScanRing **ring)
+{
+    if (bm == NULL || bm->mgmtData == NULL || ring == NULL)
+    {
+        return RC_NULL_PARAM;
+    }
+    if (numFrames < 1)
+    {
+        return RC_ERROR;
+    }
+    // the last partition is never larger than the others
+    BufferPool *pool = getBufferPool(bm);
+    int partitionFrames = pool->partitions[pool->numPartitions - 1].numFrames;
+    int maxFrames = partitionFrames / 8 > 1 ? partitionFrames / 8 : 1;
+    int size = numFrames < maxFrames ? numFrames : maxFrames;
+    int numSlots = size * pool->numPartitions;
+
+    BM_ScanRing *newRing = (BM_ScanRing *)malloc(sizeof(BM_ScanRing));
+    if (newRing == NULL)
+    {
+        return RC_MEM_ALLOC_FAILURE;
+    }
+    newRing->next = (int *)calloc(pool->numPartitions, sizeof(int));
+    newRing->frames = (int *)malloc(numSlots * sizeof(int));
+    newRing->pages = (PageNumber *)malloc(numSlots * sizeof(PageNumber));
+    if (newRing->next == NULL || newRing->frames == NULL || newRing->pages == NULL)
+    {
+        freeScanRing(newRing);
+        return RC_MEM_ALLOC_FAILURE;
+    }
+    for (int slot = 0; slot < numSlots; slot++)
+    {
+        newRing->frames[slot] = NO_PAGE;
+        newRing->pages[slot] = NO_PAGE;
+    }
+    newRing->bm = bm;
+    newRing->size = size;
+    *ring = newRing;
+    return RC_OK;
+}
+
+/*
+ Releases a scan ring. Its frames stay in the pool with whatever pages they hold.
+ */
+RC freeScanRing(BM_ScanRing *ring)
+{
+    if (ring == NULL)
+    {
+        return RC_NULL_PARAM;
+    }
+    free(ring->next);
+    free(ring->frames);
+    free(ring->pages);
+    free(ring);
+    return RC_OK;
+}
+
+/*
+ Reuses the ring's next frame in the page's partition for 'pageNum' when it still holds
+ the page the ring put there and nobody has it pinned. Returns NO_PAGE otherwise, the
+ caller then takes a frame from the partition and hands it to the ring with the slot.
+ */
+static int takeRingFrame(BPData *bpData, BM_ScanRing *ring, PageNumber pageNum)
+{
+    int slot = bpData->partition * ring->size + ring->next[bpData->partition];
+    int frame = ring->frames[slot];
+    // a resize may have left the frame outside the partition
+    if (frame == NO_PAGE || frame >= bpData->numFrames || bpData->listPageNo[frame] != ring->pages[slot] || !claimFrame(bpData, frame))
+    {
+        return NO_PAGE;
+    }
+
+    // the strategy sees the frame as loaded afresh; LFU must not count the old page's uses
+    if (bpData->lfu != NULL)
+    {
+        LFUunlinkFrame(bpData->lfu, frame);
+    }
+    BufferPoolFrame *victim = bpData->frameNodes[frame];
+    dirtypageneeded(bpData, victim);
+    updatenewpg(bpData, victim, pageNum);
+    return frame;
+}
+
+/*
+ Shared body of pinPage and pinPageWithRing; 'ring' is NULL for a regular pin. Only the
+ page's partition is latched, so pins of pages in other partitions run in parallel.
+ */
+static RC pinPageInternal(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum,
+                          BM_ScanRing *ring)
+{
+    page->pageNum = pageNum;
+    page->mode = PIN_NONE;
+    PoolFile *file = (PoolFile *)bm->mgmtData;
+    BufferPool *pool = file->pool;
+    page->pageSize = pool->pageSize;
+    if (!file->hasFile)
+    {
+        return RC_FILE_HANDLE_NOT_INIT; // the handle of a shared pool has no pages
+    }
+    if (keyFileId(pageNum) != 0)
+    {
+        return RC_READ_NON_EXISTING_PAGE; // no room for the page number in a key
+    }
+    PageNumber key = pageKey(file, pageNum);
+    BPData *bpData = partitionOf(pool, key);
+    if (__atomic_load_n(&pool->prefetchesInFlight, __ATOMIC_RELAXED) > 0)
+    {
+        pollPrefetches(pool);
+    }
+
+    RC rc;
+    if (pool->optimisticPins && pinCachedPage(bpData, page, key))
+    {
+        rc = RC_OK;
+    }
+    else
+    {
+        pthread_mutex_lock(&bpData->latch);
+        // a page still being prefetched is waited for, without holding the latch
+        while (prefetchInFlight(pool, bpData, key))
+        {
+            pthread_mutex_unlock(&bpData->latch);
+            pthread_mutex_lock(&pool->prefetchLock);
+            collectPrefetches(pool, true);
+            pthread_mutex_unlock(&pool->prefetchLock);
+            pthread_mutex_lock(&bpData->latch);
+        }
+        rc = pinPageLatched(bm, bpData, page, key, ring);
+        pthread_mutex_unlock(&bpData->latch);
+    }
+
+    if (rc == RC_OK && pool->readAhead > 0)
+    {
+        detectSequential(bm, file, pageNum);
+    }
+    return rc;
+}
+
+/*
+ Pins the page with key 'key' of the partition 'bpData', whose latch the caller holds.
+ */
+static RC pinPageLatched(BM_BufferPool *const bm, BPData *bpData, BM_PageHandle *const page,
+                         const PageNumber key, BM_ScanRing *ring)
+{
+    PoolFile *file = (PoolFile *)bm->mgmtData;
+    SM_FileHandle *sm_fileHandle = &file->fileHandle;
+    PageNumber pgIndexBP = NO_PAGE;
+    int arcTarget = bpData->arc != NULL ? bpData->arc->target : 0;
+
+    // Check if the page is in the cache
+    bool isPageInCache = findPageInCache(bpData, key, &pgIndexBP);
+
+    if (isPageInCache)
+    {
+        handleCachedPage(bm, page, pgIndexBP, key, bpData);
+        if (bpData->arc != NULL)
+        {
+            ARChit(bpData->arc, pgIndexBP);
+        }
+    }
+    else
+    {
+        // Ensure the page file has enough space for the requested page number
+        pthread_rwlock_rdlock(&file->fileLock);
+        bool grow = sm_fileHandle->totalNumPages <= page->pageNum;
+        pthread_rwlock_unlock(&file->fileLock);
+        if (grow)
+        {
+            pthread_rwlock_wrlock(&file->fileLock);
+            ensureCapacity(page->pageNum + 1, sm_fileHandle);
+            pthread_rwlock_unlock(&file->fileLock);
+        }
+
+        // If not in cache, try to add it to the buffer pool; a scan recycles its own frames first
+        if (ring != NULL && (pgIndexBP = takeRingFrame(bpData, ring, key)) != NO_PAGE)
+        {
+            // frame taken over from the ring
+        }
+        else if (bpData->pageframesavailable > 0)
+        {
+            pgIndexBP = bpData->numFrames - bpData->pageframesavailable; // Adjust based on your structure
+            addNewFrameToCache(bpData, key, pgIndexBP);
+        }
+        else
+        {
+            // Select a frame based on buffer pool strategy
+            pgIndexBP = selectPageReplacementFrame(bm, bpData, key);
+        }
+
+        // Ensure pgIndexBP is valid
+        // Check against available frames in bpData
+        if (pgIndexBP < 0 || pgIndexBP >= (bpData->numFrames - bpData->pageframesavailable))
+        {
+            return RC_PAGE_NOT_FOUND_IN_CACHE; // Handle this error appropriately
+        }
+
+        // Read the page from disk; the strategy only learns of the page once it is there
+        pthread_rwlock_rdlock(&file->fileLock);
+        RC readRC = readBlockAt(page->pageNum, sm_fileHandle, frameData(bpData, pgIndexBP));
+        pthread_rwlock_unlock(&file->fileLock);
+        if (readRC != RC_OK)
+        {
+            // the miss is forgotten: ARC takes back the target it adapted to it
+            if (bpData->arc != NULL)
+            {
+                bpData->arc->target = arcTarget;
+            }
+            vacateFrame(bpData, pgIndexBP);
+            return readRC;
+        }
+        bpData->readoperations++;
+        if (ring != NULL)
+        {
+            int *next = &ring->next[bpData->partition];
+            ring->frames[bpData->partition * ring->size + *next] = pgIndexBP;
+            ring->pages[bpData->partition * ring->size + *next] = key;
+            *next = (*next + 1) % ring->size;
+        }
+        if (bpData->lruk != NULL)
+        {
+            LRUKrestoreHistory(bpData->lruk, pgIndexBP, key);
+        }
+        if (bpData->arc != NULL)
+        {
+            ARCadmit(bpData->arc, pgIndexBP, key);
+        }
+
+        // publishes the page to optimistic pins
+        __atomic_store_n(&bpData->fixcounts[pgIndexBP], 1, __ATOMIC_RELEASE);
+    }
+
+    // Set page data
+    page->data = frameData(bpData, pgIndexBP);
+    // the CLOCK hit path is just this bit, no list reordering
+    __atomic_store_n(&bpData->refbits[pgIndexBP], true, __ATOMIC_RELAXED);
+    if (bpData->lruk != NULL)
+    {
+        LRUKtouch(bpData->lruk, pgIndexBP);
+    }
+    if (bpData->lfu != NULL)
+    {
+        LFUtouch(bpData->lfu, pgIndexBP);
+    }
+
+    return RC_OK;
+}
+
+/*
+ Here we get a page from the buffer pool for the page number and if it's there we bring it to the front.
+ Else, we get a new frame, where the page is read from disk to the frame. We then add it to cache.
+ */
+PageNumber LRUpinPageFIFO(BPData *bpData, const PageNumber pageNum)
+{
+    PageNumber bufferPoolPageIndex = NO_PAGE;
+
+    BufferPoolFrame *temp = firstframefind(bpData);
+
+    if (temp)
+    {
+        reorder(bpData, temp);
+        dirtypageneeded(bpData, bpData->endFrame);
+        updatenewpg(bpData, bpData->endFrame, pageNum);
+
+        bufferPoolPageIndex = bpData->endFrame->indexpool;
+    }
+
+    return bufferPoolPageIndex;
+}
+
+/*
+Find the first frame in the buffer pool that's unpinned and claim it for eviction.
+If none, return NULL.
+ */
+static BufferPoolFrame *firstframefind(BPData *bpData)
+{
+    BufferPoolFrame *temp = bpData->headFrame;
+    while (temp)
+    {
+        if (claimFrame(bpData, temp->indexpool))
+        {
+            return temp;
+        }
+        temp = temp->nextFrame;
+    }
+    return NULL;
+}
+
+/*
+ Empties a claimed frame whose page could not be read: the page leaves the page table and
+ the frame is filed with the strategy as the first one to evict, then unpinned. The page
+ never reached the strategy, so it keeps its LRU-K history and ARC ghost.
+ */
+static void vacateFrame(BPData *bpData, int frame)
+{
+    BufferPoolFrame *node = bpData->frameNodes[frame];
+    pageTableRemove(&bpData->pageTable, node->indexpage);
+    node->indexpage = NO_PAGE;
+    __atomic_store_n(&bpData->listPageNo[frame], NO_PAGE, __ATOMIC_RELEASE);
+
+    // FIFO and LRU evict from the head of the frame list
+    if (node != bpData->headFrame)
+    {
+        node->prevFrame->nextFrame = node->nextFrame;
+        if (node == bpData->endFrame)
+        {
+            bpData->endFrame = node->prevFrame;
+        }
+        else
+        {
+            node->nextFrame->prevFrame = node->prevFrame;
+        }
+        node->prevFrame = NULL;
+        node->nextFrame = bpData->headFrame;
+        bpData->headFrame->prevFrame = node;
+        bpData->headFrame = node;
+    }
+    // the CLOCK hand comes back to it
+    __atomic_store_n(&bpData->refbits[frame], false, __ATOMIC_RELAXED);
+    bpData->clockHand = frame;
+    if (bpData->lruk != NULL)
+    {
+        // no history at all, so it goes before pages not yet pinned too
+        bpData->lruk->history[frame].count = -1;
+        LRUKunpin(bpData->lruk, frame);
+    }
+    if (bpData->lfu != NULL)
+    {
+        LFUData *lfu = bpData->lfu;
+        LFUBucket *lowest = lfu->lowest != NULL && lfu->lowest->freq == 0 ? lfu->lowest : LFUnewBucket(lfu, 0, NULL);
+        LFUlinkFrame(lfu, frame, lowest);
+    }
+    if (bpData->arc != NULL)
+    {
+        // a prefetch files its frame in T1 before the read
+        if (bpData->arc->frameList[frame] != NULL)
+        {
+            ARCunlink(bpData->arc->frameList[frame], bpData->arc->framePrev, bpData->arc->frameNext, frame);
+        }
+        ARCpushLRU(&bpData->arc->t1, bpData->arc->framePrev, bpData->arc->frameNext, frame);
+        bpData->arc->frameList[frame] = &bpData->arc->t1;
+    }
+    __atomic_store_n(&bpData->fixcounts[frame], 0, __ATOMIC_RELEASE);
+}
+
+/*
+ Reorders the frames' linked list. This function takes a frame found as an arg
+ and puts it at the end of the list
+ */
+static void reorder(BPData *bpData, BufferPoolFrame *temp)
+{
+    // if the frame is not already at the end of the list
+    if (temp != bpData->endFrame)
+    {
+        // move  frame to end of list
+        bpData->endFrame->nextFrame = temp;
+
+        temp->nextFrame->prevFrame = temp->prevFrame;
+
+        if (temp == bpData->headFrame)
+        {
+            bpData->headFrame = bpData->headFrame->nextFrame;
+        }
+        else
+        {
+            // update next one
+            temp->prevFrame->nextFrame = temp->nextFrame;
+        }
+
+        // update previous, next pointers
+        temp->prevFrame = bpData->endFrame;
+        bpData->endFrame = bpData->endFrame->nextFrame;
+        bpData->endFrame->nextFrame = NULL;
+    }
+}
+
+/*
+ Picks a victim with the CLOCK (second chance) policy. The hand sweeps over the frames,
+ skipping pinned ones and clearing set reference bits; the first unpinned frame whose bit
+ is already clear is replaced. Two full sweeps are enough to find one, unless every
+ frame is pinned.
+ */
+static PageNumber CLOCKpinPage(BPData *bpData, PageNumber pageNum)
+{
+    for (int step = 0; step < 2 * bpData->numFrames; step++)
+    {
+        int frame = bpData->clockHand;
+        bpData->clockHand = (frame + 1) % bpData->numFrames;
+
+        if (__atomic_load_n(&bpData->fixcounts[frame], __ATOMIC_RELAXED) > 0)
+        {
+            continue;
+        }
+        if (__atomic_exchange_n(&bpData->refbits[frame], false, __ATOMIC_RELAXED))
+        {
+            // second chance
+            continue;
+        }
+        if (!claimFrame(bpData, frame))
+        {
+            continue; // pinned by an optimistic pin meanwhile
+        }
+
+        BufferPoolFrame *victim = bpData->frameNodes[frame];
+        dirtypageneeded(bpData, victim);
+        updatenewpg(bpData, victim, pageNum);
+        return frame;
+    }
+    return NO_PAGE;
+}
+
+/*
+ Sets up RS_LRU_K. stratData may point to an int K; without it K is 1, which orders
+ pages exactly like RS_LRU. Partial allocations are released by freeBpData.
+ */
+static RC initLRUK(BPData *bpData, int numPages, void *stratData)
+{
+    int k = stratData != NULL ? *(int *)stratData : 1;
+    if (k < 1)
+    {
+        return RC_ERROR;
+    }
+
+    LRUKData *lruk = (LRUKData *)calloc(1, sizeof(LRUKData));
+    if (lruk == NULL)
+    {
+        return RC_MEM_ALLOC_FAILURE;
+    }
+    bpData->lruk = lruk;
+    lruk->k = k;
+    lruk->numFrames = numPages;
+    lruk->history = (PageAccessHistory *)calloc(numPages, sizeof(PageAccessHistory));
+    lruk->heap = (int *)malloc(numPages * sizeof(int));
+    lruk->heapPos = (int *)malloc(numPages * sizeof(int));
+    lruk->retainedPages = (PageNumber *)malloc(numPages * sizeof(PageNumber));
+    lruk->retained = (PageAccessHistory *)calloc(numPages, sizeof(PageAccessHistory));
+    lruk->times = (long long *)malloc((size_t)2 * numPages * k * sizeof(long long));
+    if (!lruk->history || !lruk->heap || !lruk->heapPos || !lruk->retainedPages || !lruk->retained ||
+        !lruk->times || !pageTableInit(&lruk->retainedIndex, numPages))
+    {
+        return RC_MEM_ALLOC_FAILURE;
+    }
+
+    for (int frame = 0; frame < numPages; frame++)
+    {
+        lruk->history[frame].accessTimes = lruk->times + (size_t)frame * k;
+        lruk->retained[frame].accessTimes = lruk->times + (size_t)(numPages + frame) * k;
+        lruk->heapPos[frame] = -1;
+        lruk->retainedPages[frame] = NO_PAGE;
+    }
+    return RC_OK;
+}
+
+static void freeLRUK(LRUKData *lruk)
+{
+    if (lruk == NULL)
+    {
+        return;
+    }
+    free(lruk->history);
+    free(lruk->heap);
+    free(lruk->heapPos);
+    free(lruk->retainedPages);
+    free(lruk->retained);
+    free(lruk->times);
+    free(lruk->retainedIndex.entries);
+    free(lruk);
+}
+
+/*
+ True when the page in frame 'a' should be evicted before the one in frame 'b': the
+ larger backward K-distance (older K-th most recent access) goes first, pages seen
+ fewer than K times count as infinitely distant, and ties fall back to LRU.
+ */
+static bool LRUKbefore(LRUKData *lruk, int a, int b)
+{
+    PageAccessHistory *ha = &lruk->history[a];
+    PageAccessHistory *hb = &lruk->history[b];
+    if (ha->count < 0 || hb->count < 0)
+    {
+        return ha->count < hb->count; // an emptied frame, see vacateFrame
+    }
+    long long kthA = ha->count < lruk->k ? 0 : ha->accessTimes[ha->count % lruk->k];
+    long long kthB = hb->count < lruk->k ? 0 : hb->accessTimes[hb->count % lruk->k];
+    if (kthA != kthB)
+    {
+        return kthA < kthB;
+    }
+    // a prefetched page that was never pinned has no access yet
+    long long lastA = ha->count == 0 ? 0 : ha->accessTimes[(ha->count - 1) % lruk->k];
+    long long lastB = hb->count == 0 ? 0 : hb->accessTimes[(hb->count - 1) % lruk->k];
+    return lastA < lastB;
+}
+
+static void LRUKheapSet(LRUKData *lruk, int pos, int frame)
+{
+    lruk->heap[pos] = frame;
+    lruk->heapPos[frame] = pos;
+}
+
+// Restores the heap order around 'pos' after its frame was placed or replaced.
+static void LRUKheapFix(LRUKData *lruk, int pos)
+{
+    int frame = lruk->heap[pos];
+    // sift up
+    while (pos > 0 && LRUKbefore(lruk, frame, lruk->heap[(pos - 1) / 2]))
+    {
+        LRUKheapSet(lruk, pos, lruk->heap[(pos - 1) / 2]);
+        pos = (pos - 1) / 2;
+    }
+    // sift down
+    for (;;)
+    {
+        int child = 2 * pos + 1;
+        if (child >= lruk->heapSize)
+        {
+            break;
+        }
+        if (child + 1 < lruk->heapSize && LRUKbefore(lruk, lruk->heap[child + 1], lruk->heap[child]))
+        {
+            child++;
+        }
+        if (!LRUKbefore(lruk, lruk->heap[child], frame))
+        {
+            break;
+        }
+        LRUKheapSet(lruk, pos, lruk->heap[child]);
+        pos = child;
+    }
+    LRUKheapSet(lruk, pos, frame);
+}
+
+static void LRUKheapRemove(LRUKData *lruk, int frame)
+{
+    int pos = lruk->heapPos[frame];
+    if (pos < 0)
+    {
+        return;
+    }
+    lruk->heapPos[frame] = -1;
+    lruk->heapSize--;
+    if (pos < lruk->heapSize)
+    {
+        lruk->heap[pos] = lruk->heap[lruk->heapSize];
+        LRUKheapFix(lruk, pos);
+    }
+}
+
+/*
+ Records a pin of the page in 'frame'. Pinned frames leave the eviction heap.
+ */
+static void LRUKtouch(LRUKData *lruk, int frame)
+{
+    LRUKheapRemove(lruk, frame);
+    PageAccessHistory *history = &lruk->history[frame];
+    history->accessTimes[history->count % lruk->k] = ++lruk->clock;
+    history->count++;
+}
+
+/*
+ A frame whose fix count dropped to zero becomes an eviction candidate again.
+ */
+static void LRUKunpin(LRUKData *lruk, int frame)
+{
+    if (lruk->heapPos[frame] < 0)
+    {
+        lruk->heapSize++;
+        lruk->heap[lruk->heapSize - 1] = frame;
+        LRUKheapFix(lruk, lruk->heapSize - 1);
+    }
+}
+
+static void copyHistory(LRUKData *lruk, PageAccessHistory *to, const PageAccessHistory *from)
+{
+    memcpy(to->accessTimes, from->accessTimes, lruk->k * sizeof(long long));
+    to->count = from->count;
+}
+
+/*
+ Gives a page loaded into 'frame' the history retained from its last eviction, so a
+ page that comes back soon keeps its K-distance instead of starting over.
+ */
+static void LRUKrestoreHistory(LRUKData *lruk, int frame, PageNumber pageNum)
+{
+    int slot = pageTableLookup(&lruk->retainedIndex, pageNum);
+    if (slot == NO_PAGE)
+    {
+        lruk->history[frame].count = 0;
+        return;
+    }
+    copyHistory(lruk, &lruk->history[frame], &lruk->retained[slot]);
+    pageTableRemove(&lruk->retainedIndex, pageNum);
+    lruk->retainedPages[slot] = NO_PAGE;
+}
+
+/*
+ Keeps the history of an evicted page; the table holds as many pages as the pool
+ and overwrites its oldest entry when full.
+ */
+static void LRUKretainHistory(LRUKData *lruk, int frame, PageNumber pageNum)
+{
+    int slot = lruk->retainedNext;
+    lruk->retainedNext = (slot + 1) % lruk->numFrames;
+    if (lruk->retainedPages[slot] != NO_PAGE)
+    {
+        pageTableRemove(&lruk->retainedIndex, lruk->retainedPages[slot]);
+    }
+    copyHistory(lruk, &lruk->retained[slot], &lruk->history[frame]);
+    lruk->retainedPages[slot] = pageNum;
+    pageTableInsert(&lruk->retainedIndex, pageNum, slot);
+}
+
+/*
+ Picks a victim with LRU-K: the top of the heap is the unpinned frame with the
+ largest backward K-distance, found in O(log n).
+ */
+static PageNumber LRUKpinPage(BPData *bpData, PageNumber pageNum)
+{
+    LRUKData *lruk = bpData->lruk;
+    if (lruk->heapSize == 0)
+    {
+        return NO_PAGE; // every frame is pinned
+    }
+
+    int frame = lruk->heap[0];
+    LRUKheapRemove(lruk, frame);
+
+    BufferPoolFrame *victim = bpData->frameNodes[frame];
+    if (victim->indexpage != NO_PAGE)
+    {
+        LRUKretainHistory(lruk, frame, victim->indexpage);
+    }
+    dirtypageneeded(bpData, victim);
+    updatenewpg(bpData, victim, pageNum);
+    return frame;
+}
+
+/*
+ Sets up RS_LFU. stratData may point to an int aging interval: every that many pins all
+ frequencies are halved, so pages that were hot long ago eventually leave. NULL or 0
+ disables aging. Partial allocations are released by freeBpData.
+ */
+static RC initLFU(BPData *bpData, int numPages, void *stratData)
+{
+    int agingInterval = stratData != NULL ? *(int *)stratData : 0;
+    if (agingInterval < 0)
+    {
+        return RC_ERROR;
+    }
+
+    LFUData *lfu = (LFUData *)calloc(1, sizeof(LFUData));
+    if (lfu == NULL)
+    {
+        return RC_MEM_ALLOC_FAILURE;
+    }
+    bpData->lfu = lfu;
+    lfu->agingInterval = agingInterval;
+    // one bucket per frame at most, plus one while a frame moves to a new bucket
+    lfu->buckets = (LFUBucket *)malloc((numPages + 1) * sizeof(LFUBucket));
+    lfu->bucketOf = (LFUBucket **)calloc(numPages, sizeof(LFUBucket *));
+    lfu->newer = (int *)malloc(numPages * sizeof(int));
+    lfu->older = (int *)malloc(numPages * sizeof(int));
+    if (!lfu->buckets || !lfu->bucketOf || !lfu->newer || !lfu->older)
+    {
+        return RC_MEM_ALLOC_FAILURE;
+    }
+
+    for (int i = 0; i <= numPages; i++)
+    {
+        lfu->buckets[i].next = i < numPages ? &lfu->buckets[i + 1] : NULL;
+    }
+    lfu->freeBuckets = lfu->buckets;
+    return RC_OK;
+}
+
+static void freeLFU(LFUData *lfu)
+{
+    if (lfu == NULL)
+    {
+        return;
+    }
+    free(lfu->buckets);
+    free(lfu->bucketOf);
+    free(lfu->newer);
+    free(lfu->older);
+    free(lfu);
+}
+
+// Takes an empty bucket from the free list and links it into the bucket list after 'prev'.
+static LFUBucket *LFUnewBucket(LFUData *lfu, long long freq, LFUBucket *prev)
+{
+    LFUBucket *bucket = lfu->freeBuckets;
+    lfu->freeBuckets = bucket->next;
+    bucket->freq = freq;
+    bucket->head = bucket->tail = -1;
+    bucket->prev = prev;
+    bucket->next = prev != NULL ? prev->next : lfu->lowest;
+    if (bucket->next != NULL)
+    {
+        bucket->next->prev = bucket;
+    }
+    if (prev != NULL)
+    {
+        prev->next = bucket;
+    }
+    else
+    {
+        lfu->lowest = bucket;
+    }
+    return bucket;
+}
+
+// Unlinks an empty bucket from the bucket list and returns it to the free list.
+static void LFUfreeBucket(LFUData *lfu, LFUBucket *bucket)
+{
+    if (bucket->prev != NULL)
+    {
+        bucket->prev->next = bucket->next;
+    }
+    else
+    {
+        lfu->lowest = bucket->next;
+    }
+    if (bucket->next != NULL)
+    {
+        bucket->next->prev = bucket->prev;
+    }
+    bucket->next = lfu->freeBuckets;
+    lfu->freeBuckets = bucket;
+}
+
+// Makes a frame the most recently used one of a bucket.
+static void LFUlinkFrame(LFUData *lfu, int frame, LFUBucket *bucket)
+{
+    lfu->bucketOf[frame] = bucket;
+    lfu->older[frame] = bucket->head;
+    lfu->newer[frame] = -1;
+    if (bucket->head != -1)
+    {
+        lfu->newer[bucket->head] = frame;
+    }
+    else
+    {
+        bucket->tail = frame;
+    }
+    bucket->head = frame;
+}
+
+// Takes a frame out of its bucket, dropping the bucket once it is empty.
+static void LFUunlinkFrame(LFUData *lfu, int frame)
+{
+    LFUBucket *bucket = lfu->bucketOf[frame];
+    if (lfu->older[frame] != -1)
+    {
+        lfu->newer[lfu->older[frame]] = lfu->newer[frame];
+    }
+    else
+    {
+        bucket->tail = lfu->newer[frame];
+    }
+    if (lfu->newer[frame] != -1)
+    {
+        lfu->older[lfu->newer[frame]] = lfu->older[frame];
+    }
+    else
+    {
+        bucket->head = lfu->older[frame];
+    }
+    lfu->bucketOf[frame] = NULL;
+    if (bucket->head == -1)
+    {
+        LFUfreeBucket(lfu, bucket);
+    }
+}
+
+/*
+ Halves every frequency. Buckets stay sorted, so only neighbours can collide; a bucket
+ whose halved frequency equals the previous one is merged into it, its frames counting
+ as more recent.
+ */
+static void LFUage(LFUData *lfu)
+{
+    LFUBucket *bucket = lfu->lowest;
+    while (bucket != NULL)
+    {
+        LFUBucket *next = bucket->next;
+        bucket->freq /= 2;
+        LFUBucket *prev = bucket->prev;
+        if (prev != NULL && prev->freq == bucket->freq)
+        {
+            for (int frame = bucket->head; frame != -1; frame = lfu->older[frame])
+            {
+                lfu->bucketOf[frame] = prev;
+            }
+            lfu->older[bucket->tail] = prev->head;
+            lfu->newer[prev->head] = bucket->tail;
+            prev->head = bucket->head;
+            LFUfreeBucket(lfu, bucket);
+        }
+        bucket = next;
+    }
+}
+
+/*
+ Counts a pin of the page in 'frame' in O(1): the frame moves to the bucket of the next
+ frequency, which is either the neighbouring bucket or a new one right after it. A
+ freshly loaded page starts with frequency 1.
+ */
+static void LFUtouch(LFUData *lfu, int frame)
+{
+    LFUBucket *from = lfu->bucketOf[frame];
+    LFUBucket *to;
+    if (from == NULL)
+    {
+        // only aging produces frequencies below 1
+        LFUBucket *prev = lfu->lowest != NULL && lfu->lowest->freq < 1 ? lfu->lowest : NULL;
+        LFUBucket *next = prev != NULL ? prev->next : lfu->lowest;
+        to = next != NULL && next->freq == 1 ? next : LFUnewBucket(lfu, 1, prev);
+    }
+    else
+    {
+        LFUBucket *next = from->next;
+        to = next != NULL && next->freq == from->freq + 1 ? next : LFUnewBucket(lfu, from->freq + 1, from);
+        LFUunlinkFrame(lfu, frame);
+    }
+    LFUlinkFrame(lfu, frame, to);
+
+    if (lfu->agingInterval > 0 && ++lfu->pinsSinceAging >= lfu->agingInterval)
+    {
+        LFUage(lfu);
+        lfu->pinsSinceAging = 0;
+    }
+}
+
+/*
+ Picks a victim with LFU: the least recently used unpinned frame of the lowest
+ frequency bucket. Pinned frames stay in their buckets and are skipped.
+ */
+static PageNumber LFUpinPage(BPData *bpData, PageNumber pageNum)
+{
+    LFUData *lfu = bpData->lfu;
+
+    for (LFUBucket *bucket = lfu->lowest; bucket != NULL; bucket = bucket->next)
+    {
+        for (int frame = bucket->tail; frame != -1; frame = lfu->newer[frame])
+        {
+            if (bpData->fixcounts[frame] > 0)
+            {
+                continue;
+            }
+            LFUunlinkFrame(lfu, frame);
+            BufferPoolFrame *victim = bpData->frameNodes[frame];
+            dirtypageneeded(bpData, victim);
+            updatenewpg(bpData, victim, pageNum);
+            return frame;
+        }
+    }
+    return NO_PAGE; // every frame is pinned
+}
+
+/*
+ Sets up RS_ARC for a pool of 'numPages' frames. Partial allocations are released by
+ freeBpData.
+ */
+static RC initARC(BPData *bpData, int numPages)
+{
+    ARCData *arc = (ARCData *)calloc(1, sizeof(ARCData));
+    if (arc == NULL)
+    {
+        return RC_MEM_ALLOC_FAILURE;
+    }
+    bpData->arc = arc;
+    arc->capacity = numPages;
+    // the ghost lists never hold more than the pool; one spare slot covers pinned-frame fallbacks
+    int numGhosts = numPages + 1;
+    arc->framePrev = (int *)malloc(numPages * sizeof(int));
+    arc->frameNext = (int *)malloc(numPages * sizeof(int));
+    arc->frameList = (ARCList **)calloc(numPages, sizeof(ARCList *));
+    arc->ghostPage = (PageNumber *)malloc(numGhosts * sizeof(PageNumber));
+    arc->ghostPrev = (int *)malloc(numGhosts * sizeof(int));
+    arc->ghostNext = (int *)malloc(numGhosts * sizeof(int));
+    arc->ghostList = (ARCList **)calloc(numGhosts, sizeof(ARCList *));
+    if (!arc->framePrev || !arc->frameNext || !arc->frameList || !arc->ghostPage || !arc->ghostPrev ||
+        !arc->ghostNext || !arc->ghostList || !pageTableInit(&arc->ghostIndex, numGhosts))
+    {
+        return RC_MEM_ALLOC_FAILURE;
+    }
+
+    ARCList empty = {-1, -1, 0};
+    arc->t1 = arc->t2 = arc->b1 = arc->b2 = empty;
+    // free ghost slots are chained through ghostNext
+    for (int slot = 0; slot < numGhosts; slot++)
+    {
+        arc->ghostNext[slot] = slot + 1 < numGhosts ? slot + 1 : -1;
+    }
+    arc->freeGhost = 0;
+    return RC_OK;
+}
+
+static void freeARC(ARCData *arc)
+{
+    if (arc == NULL)
+    {
+        return;
+    }
+    free(arc->framePrev);
+    free(arc->frameNext);
+    free(arc->frameList);
+    free(arc->ghostPage);
+    free(arc->ghostPrev);
+    free(arc->ghostNext);
+    free(arc->ghostList);
+    free(arc->ghostIndex.entries);
+    free(arc);
+}
+
+// Appends a node at the MRU end of a list whose links live in prev/next.
+static void ARCpush(ARCList *list, int *prev, int *next, int node)
+{
+    prev[node] = list->mru;
+    next[node] = -1;
+    if (list->mru != -1)
+    {
+        next[list->mru] = node;
+    }
+    else
+    {
+        list->lru = node;
+    }
+    list->mru = node;
+    list->size++;
+}
+
+// Puts a node at the LRU end of a list, the first one REPLACE takes from it.
+static void ARCpushLRU(ARCList *list, int *prev, int *next, int node)
+{
+    prev[node] = -1;
+    next[node] = list->lru;
+    if (list->lru != -1)
+    {
+        prev[list->lru] = node;
+    }
+    else
+    {
+        list->mru = node;
+    }
+    list->lru = node;
+    list->size++;
+}
+
+static void ARCunlink(ARCList *list, int *prev, int *next, int node)
+{
+    if (prev[node] != -1)
+    {
+        next[prev[node]] = next[node];
+    }
+    else
+    {
+        list->lru = next[node];
+    }
+    if (next[node] != -1)
+    {
+        prev[next[node]] = prev[node];
+    }
+    else
+    {
+        list->mru = prev[node];
+    }
+    list->size--;
+}
+
+static void ARCmoveFrame(ARCData *arc, int frame, ARCList *to)
+{
+    if (arc->frameList[frame] != NULL)
+    {
+        ARCunlink(arc->frameList[frame], arc->framePrev, arc->frameNext, frame);
+    }
+    ARCpush(to, arc->framePrev, arc->frameNext, frame);
+    arc->frameList[frame] = to;
+}
+
+static void ARCdropGhost(ARCData *arc, int slot)
+{
+    ARCunlink(arc->ghostList[slot], arc->ghostPrev, arc->ghostNext, slot);
+    pageTableRemove(&arc->ghostIndex, arc->ghostPage[slot]);
+    arc->ghostList[slot] = NULL;
+    arc->ghostNext[slot] = arc->freeGhost;
+    arc->freeGhost = slot;
+}
+
+// Remembers an evicted page at the MRU end of a ghost list.
+static void ARCaddGhost(ARCData *arc, ARCList *list, PageNumber pageNum)
+{
+    if (arc->freeGhost == -1)
+    {
+        ARCdropGhost(arc, arc->b1.size > 0 ? arc->b1.lru : arc->b2.lru);
+    }
+    int slot = arc->freeGhost;
+    arc->freeGhost = arc->ghostNext[slot];
+    arc->ghostPage[slot] = pageNum;
+    arc->ghostList[slot] = list;
+    ARCpush(list, arc->ghostPrev, arc->ghostNext, slot);
+    pageTableInsert(&arc->ghostIndex, pageNum, slot);
+}
+
+// Least recently used unpinned frame of a resident list, or -1.
+static int ARColdestUnpinned(ARCData *arc, ARCList *list, const int *fixcounts)
+{
+    for (int frame = list->lru; frame != -1; frame = arc->frameNext[frame])
+    {
+        if (fixcounts[frame] == 0)
+        {
+            return frame;
+        }
+    }
+    return -1;
+}
+
+/*
+ The frame REPLACE evicts for a page found in 'ghost' (NULL for an unknown page) once the
+ target is 'target': the LRU end of T1 while T1 is above its target, of T2 otherwise, or -1
+ if every frame is pinned.
+ */
+static int ARCreplaceFrame(ARCData *arc, ARCList *ghost, int target, const int *fixcounts)
+{
+    bool fromT1 = arc->t1.size >= 1 &&
+                  ((ghost == &arc->b2 && arc->t1.size == target) || arc->t1.size > target);
+    int frame = ARColdestUnpinned(arc, fromT1 ? &arc->t1 : &arc->t2, fixcounts);
+    if (frame == -1)
+    {
+        frame = ARColdestUnpinned(arc, fromT1 ? &arc->t2 : &arc->t1, fixcounts);
+    }
+    return frame;
+}
+
+// Forgets the ghost of a page, if ARC remembers one.
+static void ARCforget(ARCData *arc, PageNumber pageNum)
+{
+    int slot = pageTableLookup(&arc->ghostIndex, pageNum);
+    if (slot != NO_PAGE)
+    {
+        ARCdropGhost(arc, slot);
+    }
+}
+
+/*
+ A hit moves the frame to the MRU end of T2, the list of pages seen at least twice.
+ */
+static void ARChit(ARCData *arc, int frame)
+{
+    ARCmoveFrame(arc, frame, &arc->t2);
+}
+
+/*
+ Files a freshly loaded page: back into T2 when ARC still remembered it in a ghost list,
+ otherwise into T1.
+ */
+static void ARCadmit(ARCData *arc, int frame, PageNumber pageNum)
+{
+    int slot = pageTableLookup(&arc->ghostIndex, pageNum);
+    if (slot != NO_PAGE)
+    {
+        ARCdropGhost(arc, slot);
+        ARCmoveFrame(arc, frame, &arc->t2);
+    }
+    else
+    {
+        ARCmoveFrame(arc, frame, &arc->t1);
+    }
+}
+
+/*
+ Picks a victim with ARC. A miss on a page remembered in B1 means T1 was too small, so the
+ target size p of T1 grows; a miss in B2 shrinks it. REPLACE then evicts from T1 while T1
+ is above its target and from T2 otherwise, and remembers the evicted page in B1 or B2.
+ Misses on unknown pages trim the ghost lists so that T1 + B1 and the whole directory
+ stay within one and two pool sizes. Pinned frames are passed over, falling back to the
+ other list when one has nothing unpinned.
+ */
+static PageNumber ARCpinPage(BPData *bpData, PageNumber pageNum)
+{
+    ARCData *arc = bpData->arc;
+    int c = arc->capacity;
+
+    int slot = pageTableLookup(&arc->ghostIndex, pageNum);
+    ARCList *ghost = slot != NO_PAGE ? arc->ghostList[slot] : NULL;
+
+    // adapt the target size of T1
+    int target = arc->target;
+    if (ghost == &arc->b1)
+    {
+        int delta = arc->b2.size / arc->b1.size > 1 ? arc->b2.size / arc->b1.size : 1;
+        target = target + delta < c ? target + delta : c;
+    }
+    else if (ghost == &arc->b2)
+    {
+        int delta = arc->b1.size / arc->b2.size > 1 ? arc->b1.size / arc->b2.size : 1;
+        target = target - delta > 0 ? target - delta : 0;
+    }
+
+    // a full T1 with no history is evicted from directly, without keeping a ghost
+    bool keepGhost = !(ghost == NULL && arc->t1.size + arc->b1.size == c && arc->b1.size == 0);
+
+    int frame = ARCreplaceFrame(arc, ghost, target, bpData->fixcounts);
+    if (frame == -1)
+    {
+        return NO_PAGE; // every frame is pinned
+    }
+    arc->target = target;
+
+    // make room in the ghost lists for an unknown page
+    if (ghost == NULL && keepGhost)
+    {
+        if (arc->t1.size + arc->b1.size == c && arc->b1.size > 0)
+        {
+            ARCdropGhost(arc, arc->b1.lru);
+        }
+        else if (arc->t1.size + arc->t2.size + arc->b1.size + arc->b2.size >= 2 * c && arc->b2.size > 0)
+        {
+            ARCdropGhost(arc, arc->b2.lru);
+        }
+    }
+
+    BufferPoolFrame *victim = bpData->frameNodes[frame];
+    ARCList *from = arc->frameList[frame];
+    ARCunlink(from, arc->framePrev, arc->frameNext, frame);
+    arc->frameList[frame] = NULL;
+    if (keepGhost && victim->indexpage != NO_PAGE)
+    {
+        ARCaddGhost(arc, from == &arc->t1 ? &arc->b1 : &arc->b2, victim->indexpage);
+    }
+
+    dirtypageneeded(bpData, victim);
+    updatenewpg(bpData, victim, pageNum);
+    return frame;
+}
+
+/*
+ Takes an unpinned frame for eviction: its fix count goes from 0 to FRAME_CLAIMED, which
+ optimistic pins cannot get past. Fails if the frame is pinned.
+ */
+static bool claimFrame(BPData *bpData, int frame)
+{
+    int unpinned = 0;
+    return __atomic_compare_exchange_n(&bpData->fixcounts[frame], &unpinned, FRAME_CLAIMED, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+// Drops one pin, never below zero.
+static void releasePin(int *fixcount)
+{
+    int pins = __atomic_load_n(fixcount, __ATOMIC_RELAXED);
+    while (pins > 0 && !__atomic_compare_exchange_n(fixcount, &pins, pins - 1, true,
+                                                     __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+/*
+ Pins a cached page without the partition latch: the fix count is raised by compare and
+ swap unless the frame is claimed, and the frame's page number is checked afterwards.
+ The page number serves as the frame's version; if the frame was reloaded with another
+ page in between, the pin is given back. Returns false when the caller must take the
+ latched path instead.
+ */
+static bool pinCachedPage(BPData *bpData, BM_PageHandle *const page, PageNumber pageNum)
+{
+    int frame = pageTableLookupShared(&bpData->pageTable, pageNum);
+    if (frame == NO_PAGE)
+    {
+        return false;
+    }
+
+    int pins = __atomic_load_n(&bpData->fixcounts[frame], __ATOMIC_RELAXED);
+    do
+    {
+        if (pins == FRAME_CLAIMED)
+        {
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&bpData->fixcounts[frame], &pins, pins + 1, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    if (__atomic_load_n(&bpData->listPageNo[frame], __ATOMIC_ACQUIRE) != pageNum)
+    {
+        releasePin(&bpData->fixcounts[frame]);
+        return false;
+    }
+    __atomic_store_n(&bpData->refbits[frame], true, __ATOMIC_RELAXED);
+    page->data = frameData(bpData, frame);
+    return true;
+}
+
+/*
+ Unpins a page without the partition latch. The caller's pin keeps the frame from being
+ evicted, so only the lookup can fail.
+ */
+static bool unpinCachedPage(BPData *bpData, PageNumber pageNum)
+{
+    int frame = pageTableLookupShared(&bpData->pageTable, pageNum);
+    if (frame == NO_PAGE || __atomic_load_n(&bpData->listPageNo[frame], __ATOMIC_ACQUIRE) != pageNum)
+    {
+        return false;
+    }
+    releasePin(&bpData->fixcounts[frame]);
+    return true;
+}
+
+/*
+ Starts the background cleaner of a pool whose partitions are set up. The watermarks
+ were checked by initBufferPoolWithOptions.
+ */
+static RC startCleaner(BufferPool *pool, int numPages, ReplacementStrategy strategy,
+                       const BM_PoolOptions *options)
+{
+    PageCleaner *cleaner = (PageCleaner *)calloc(1, sizeof(PageCleaner));
+    if (cleaner == NULL)
+    {
+        return RC_MEM_ALLOC_FAILURE;
+    }
+    cleaner->strategy = strategy;
+    cleaner->highPercent = options->dirtyHighWatermark > 0 ? options->dirtyHighWatermark : CLEANER_HIGH_WATERMARK;
+    cleaner->lowPercent = options->dirtyLowWatermark > 0 ? options->dirtyLowWatermark : CLEANER_LOW_WATERMARK;
+    setWatermarks(cleaner, numPages);
+
+    // copies are page aligned like the frames, for O_DIRECT writes
+    void *copies = NULL;
+    if (posix_memalign(&copies, PAGE_SIZE, (size_t)CLEANER_BATCH * pool->pageSize) == 0)
+    {
+        cleaner->copies = (char *)copies;
+    }
+    cleaner->entries = (FlushEntry *)malloc(CLEANER_BATCH * sizeof(FlushEntry));
+    cleaner->runPages = (SM_PageHandle *)malloc(CLEANER_BATCH * sizeof(SM_PageHandle));
+    cleaner->frames = (int *)malloc(CLEANER_BATCH * sizeof(int));
+    cleaner->written = (bool *)malloc(CLEANER_BATCH * sizeof(bool));
+    // the first partition is never smaller than the others
+    cleaner->order = (int *)malloc(pool->partitions[0].numFrames * sizeof(int));
+    bool allocated = cleaner->copies && cleaner->entries && cleaner->runPages && cleaner->frames &&
+                     cleaner->written && cleaner->order;
+
+    pthread_mutex_init(&cleaner->lock, NULL);
+    pthread_cond_init(&cleaner->wake, NULL);
+    pool->cleaner = cleaner;
+    if (allocated && pthread_create(&cleaner->thread, NULL, cleanerThread, pool) == 0)
+    {
+        return RC_OK;
+    }
+
+    pool->cleaner = NULL;
+    pthread_cond_destroy(&cleaner->wake);
+    pthread_mutex_destroy(&cleaner->lock);
+    freeCleaner(cleaner);
+    return allocated ? RC_ERROR : RC_MEM_ALLOC_FAILURE;
+}
+
+// Turns the watermark percentages into numbers of dirty frames for a pool of numFrames
+static void setWatermarks(PageCleaner *cleaner, int numFrames)
+{
+    int high = numFrames * cleaner->highPercent / 100;
+    int low = numFrames * cleaner->lowPercent / 100;
+    cleaner->highWatermark = high > 1 ? high : 1;
+    cleaner->lowWatermark = low < cleaner->highWatermark ? low : cleaner->highWatermark - 1;
+}
+
+static void freeCleaner(PageCleaner *cleaner)
+{
+    free(cleaner->copies);
+    free(cleaner->entries);
+    free(cleaner->runPages);
+    free(cleaner->frames);
+    free(cleaner->written);
+    free(cleaner->order);
+    free(cleaner);
+}
+
+/*
+ Stops the cleaner of a pool that is shutting down. Fails, leaving the cleaner running,
+ if pages are still pinned; the cleaner's own pins are only held during a round.
+ */
+static RC stopCleaner(BufferPool *pool, int numPages)
+{
+    PageCleaner *cleaner = pool->cleaner;
+    if (cleaner == NULL)
+    {
+        return hasPinnedPages(pool, numPages, NULL) ? RC_SHUTDOWN_POOL_ERROR : RC_OK;
+    }
+
+    pthread_mutex_lock(&cleaner->lock);
+    if (hasPinnedPages(pool, numPages, NULL))
+    {
+        pthread_mutex_unlock(&cleaner->lock);
+        return RC_SHUTDOWN_POOL_ERROR;
+    }
+    cleaner->stop = true;
+    pthread_cond_signal(&cleaner->wake);
+    pthread_mutex_unlock(&cleaner->lock);
+    pthread_join(cleaner->thread, NULL);
+
+    pool->cleaner = NULL;
+    pthread_cond_destroy(&cleaner->wake);
+    pthread_mutex_destroy(&cleaner->lock);
+    freeCleaner(cleaner);
+    return RC_OK;
+}
+
+// Called by markDirty with the new number of dirty frames; wakes the cleaner at the high watermark
+static void cleanerNoteDirty(BufferPool *pool, int numDirty)
+{
+    if (pool->cleaner != NULL && numDirty == pool->cleaner->highWatermark)
+    {
+        pthread_cond_signal(&pool->cleaner->wake);
+    }
+}
+
+/*
+ Fills 'order' with the resident frames of a partition, the ones the strategy would evict
+ first at the front, and returns their number. LRU-K gives its heap in array order, which
+ starts with the next victim; the partition latch must be held.
+ */
+static int evictionOrder(ReplacementStrategy strategy, BPData *bpData, int *order)
+{
+    int count = 0;
+    if (bpData->lruk != NULL)
+    {
+        memcpy(order, bpData->lruk->heap, bpData->lruk->heapSize * sizeof(int));
+        count = bpData->lruk->heapSize;
+    }
+    else if (bpData->lfu != NULL)
+    {
+        for (LFUBucket *bucket = bpData->lfu->lowest; bucket != NULL; bucket = bucket->next)
+        {
+            for (int frame = bucket->tail; frame != -1; frame = bpData->lfu->newer[frame])
+            {
+                order[count++] = frame;
+            }
+        }
+    }
+    else if (bpData->arc != NULL)
+    {
+        for (int frame = bpData->arc->t1.lru; frame != -1; frame = bpData->arc->frameNext[frame])
+        {
+            order[count++] = frame;
+        }
+        for (int frame = bpData->arc->t2.lru; frame != -1; frame = bpData->arc->frameNext[frame])
+        {
+            order[count++] = frame;
+        }
+    }
+    else if (strategy == RS_CLOCK)
+    {
+        for (int step = 0; step < bpData->numFrames; step++)
+        {
+            order[count++] = (bpData->clockHand + step) % bpData->numFrames;
+        }
+    }
+    else
+    {
+        for (BufferPoolFrame *frame = bpData->headFrame; frame != NULL; frame = frame->nextFrame)
+        {
+            order[count++] = frame->indexpool;
+        }
+    }
+    return count;
+}
+
+/*
+ Fills 'order' with the resident frames of a partition nobody uses, in the exact order its
+ strategy would evict them one after the other, and returns their number; used to resize
+ a pool and to save it for a warm restart. Unlike
+ evictionOrder, LRU-K comes sorted, ARC takes from T1 while T1 is above its target as
+ REPLACE does, and CLOCK takes the frames without a reference bit first, like a sweep of
+ the hand.
+ */
+static int victimOrder(ReplacementStrategy strategy, BPData *bpData, int *order)
+{
+    int count = 0;
+    if (bpData->lruk != NULL)
+    {
+        // empty the heap in order, then put the frames back
+        LRUKData *lruk = bpData->lruk;
+        while (lruk->heapSize > 0)
+        {
+            order[count] = lruk->heap[0];
+            LRUKheapRemove(lruk, order[count++]);
+        }
+        for (int pos = 0; pos < count; pos++)
+        {
+            LRUKunpin(lruk, order[pos]);
+        }
+    }
+    else if (bpData->arc != NULL)
+    {
+        ARCData *arc = bpData->arc;
+        int t1 = arc->t1.lru;
+        int t2 = arc->t2.lru;
+        int t1Size = arc->t1.size;
+        while (t1 != -1 || t2 != -1)
+        {
+            if (t1 != -1 && (t2 == -1 || t1Size > arc->target))
+            {
+                order[count++] = t1;
+                t1 = arc->frameNext[t1];
+                t1Size--;
+            }
+            else
+            {
+                order[count++] = t2;
+                t2 = arc->frameNext[t2];
+            }
+        }
+    }
+    else if (strategy == RS_CLOCK)
+    {
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (int step = 0; step < bpData->numFrames; step++)
+            {
+                int frame = (bpData->clockHand + step) % bpData->numFrames;
+                if (bpData->listPageNo[frame] != NO_PAGE && bpData->refbits[frame] == (pass == 1))
+                {
+                    order[count++] = frame;
+                }
+            }
+        }
+    }
+    else
     {
-        return RC_MEM_ALLOC_FAILURE;
+        count = evictionOrder(strategy, bpData, order);
     }
-    
-    RC status = openPageFile(mutablePageFile, &fileHandle);
-    free(mutablePageFile);
 
-    if (status != RC_OK)
+    // frames emptied by a failed read hold nothing to keep
+    int kept = 0;
+    for (int pos = 0; pos < count; pos++)
     {
-        return status;
+        if (bpData->listPageNo[order[pos]] != NO_PAGE)
+        {
+            order[kept++] = order[pos];
+        }
     }
+    count = kept;
+    return count;
+}
 
-    // Write the page data to the file using the page file and the actual page number
-    status = writeBlock(pageNum, &fileHandle, pageHandle);
+/*
+ Loads the page of frame oldFrame of a partition being resized into the next free frame
+ of its new partition, with its data, dirty flag and standing in the strategy.
+ */
+static void moveFrame(BPData *from, int oldFrame, BPData *to)
+{
+    FrameState state;
+    frameState(from, oldFrame, &state);
+    int frame = admitFrame(to, &state, from->lruk != NULL ? from->lruk->history[oldFrame].accessTimes : NULL);
+    memcpy(frameData(to, frame), frameData(from, oldFrame), to->pageSize);
+    to->dirtyflag[frame] = from->dirtyflag[oldFrame];
+}
 
-    // Close the page file
-    closePageFile(&fileHandle);
-    return status;
+// Describes the page in a frame the way admitFrame takes it
+static void frameState(BPData *bpData, int frame, FrameState *state)
+{
+    state->pageNum = bpData->listPageNo[frame];
+    state->refbit = bpData->refbits[frame];
+    state->frequent = bpData->arc != NULL && bpData->arc->frameList[frame] == &bpData->arc->t2;
+    state->freq = bpData->lfu != NULL ? bpData->lfu->bucketOf[frame]->freq : 1;
+    state->count = bpData->lruk != NULL ? bpData->lruk->history[frame].count : 0;
 }
 
-/**
- * This writes the page data to disk and marks the page as no longer dirty.
- * If the page is found, it writes the page data to disk using the page file and the actual page no.
- * Then, it resets the dirty flag for the page in the buffer pool data and increments the write op counter.
- * Then returns the success RC_OK code.
+/*
+ Maps a page to the next free frame of a partition nobody uses and gives it the standing
+ 'state' describes; times holds its last K access times for LRU-K, or is NULL if the page
+ has no history. Returns the frame, which is clean and unpinned and still has to get
+ the page's data. Pages admitted in eviction order come out in the same order.
  */
-RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page)
+static int admitFrame(BPData *to, const FrameState *state, const long long *times)
 {
-    // Get the buffer pool data
-    BPData *bpData = (BPData *)bm->mgmtData;
-    // Get the actual page number from the page handle
-    PageNumber actualPageNumber = page->pageNum;
-    // Find the index of the page in the buffer pool
-    PageNumber bufferPoolPageNumber = findPageInBuffer(bpData, actualPageNumber, bm->numPages);
+    int frame = to->numFrames - to->pageframesavailable;
+    addNewFrameToCache(to, state->pageNum, frame);
+    to->refbits[frame] = state->refbit;
+    to->fixcounts[frame] = 0;
 
-    if (bufferPoolPageNumber == NO_PAGE)
+    if (to->lruk != NULL)
     {
-        return RC_PAGE_NOT_FOUND_IN_CACHE;
+        to->lruk->history[frame].count = 0;
+        if (times != NULL)
+        {
+            memcpy(to->lruk->history[frame].accessTimes, times, to->lruk->k * sizeof(long long));
+            to->lruk->history[frame].count = state->count;
+        }
+        LRUKunpin(to->lruk, frame);
     }
-    RC status = writePageToFile(bm->pageFile, actualPageNumber, page->data);
-    if (status != RC_OK)
+    else if (to->lfu != NULL)
+    {
+        // the bucket of the last page admitted is a good place to start looking
+        LFUBucket *bucket = frame > 0 ? to->lfu->bucketOf[frame - 1] : to->lfu->lowest;
+        while (bucket != NULL && bucket->freq > state->freq && bucket->prev != NULL)
+        {
+            bucket = bucket->prev;
+        }
+        while (bucket != NULL && bucket->next != NULL && bucket->next->freq <= state->freq)
+        {
+            bucket = bucket->next;
+        }
+        if (bucket == NULL || bucket->freq != state->freq)
+        {
+            bucket = LFUnewBucket(to->lfu, state->freq, bucket != NULL && bucket->freq < state->freq ? bucket : NULL);
+        }
+        LFUlinkFrame(to->lfu, frame, bucket);
+    }
+    else if (to->arc != NULL)
     {
-        return status;
+        ARCmoveFrame(to->arc, frame, state->frequent ? &to->arc->t2 : &to->arc->t1);
     }
-
-    // Mark the page as not dirty
-    bpData->dirtyflag[bufferPoolPageNumber] = false;
-    // Increment write operations counter
-    bpData->writeoperations++;
-    return RC_OK;
+    return frame;
 }
 
-// Helper function to get buffer pool data
-static inline BPData *getBpData(BM_BufferPool *const bm)
-{
-    return (BPData *)bm->mgmtData;
-}
-
-/**
- * Returns an array of PageNumber containing the page numbers of all the frames in the buffer pool.
+/*
+ One cleaning round: takes up to 'budget' dirty unpinned frames from the eviction end of
+ the partitions, writes them and returns how many were written. Only frames nobody has
+ pinned are taken; each is copied and marked clean under its partition latch, and stays
+ pinned by the cleaner until the copy is on disk, so it cannot be evicted and read back
+ stale in between. A page changed meanwhile is simply dirty again.
  */
-PageNumber *getFrameContents(BM_BufferPool *const bm)
+static int cleanRound(BufferPool *pool, int budget)
 {
-    return getBpData(bm)->listPageNo;
-}
+    PageCleaner *cleaner = pool->cleaner;
+    int taken = 0;
+    budget = budget < CLEANER_BATCH ? budget : CLEANER_BATCH;
 
-/**
- * Returns an array of of bools that indicate whether each page in the buffer pool is dirty or not.
- */
-bool *getDirtyFlags(BM_BufferPool *const bm)
-{
-    return getBpData(bm)->dirtyflag;
-}
+    for (int i = 0; i < pool->numPartitions && taken < budget; i++)
+    {
+        BPData *bpData = &pool->partitions[(cleaner->nextPartition + i) % pool->numPartitions];
+        pthread_mutex_lock(&bpData->latch);
+        int count = evictionOrder(cleaner->strategy, bpData, cleaner->order);
+        for (int pos = 0; pos < count && taken < budget; pos++)
+        {
+            int frame = cleaner->order[pos];
+            // the claim keeps optimistic pins out while the page is copied
+            if (!bpData->dirtyflag[frame] || !claimFrame(bpData, frame))
+            {
+                continue;
+            }
+            if (bpData->lruk != NULL)
+            {
+                LRUKheapRemove(bpData->lruk, frame);
+            }
+            memcpy(cleaner->copies + (size_t)taken * pool->pageSize, frameData(bpData, frame), pool->pageSize);
+            bpData->dirtyflag[frame] = false;
+            __atomic_sub_fetch(bpData->numDirty, 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&bpData->fixcounts[frame], 1, __ATOMIC_RELEASE);
 
-/**
- * Returns an array of integers showing the number of times each page in the buffer pool
- * has been fixed
- */
-int *getFixCounts(BM_BufferPool *const bm)
-{
-    return getBpData(bm)->fixcounts;
-}
+            cleaner->entries[taken].pageNum = bpData->listPageNo[frame];
+            cleaner->entries[taken].frame = taken;
+            cleaner->frames[taken] = bpData->firstFrame + frame;
+            taken++;
+        }
+        pthread_mutex_unlock(&bpData->latch);
+    }
+    cleaner->nextPartition = (cleaner->nextPartition + 1) % pool->numPartitions;
+    if (taken == 0)
+    {
+        return 0;
+    }
 
-/**
- * Returns the number of read I/O operations performed by the buffer pool.
- */
-int getNumReadIO(BM_BufferPool *const bm)
-{
-    return getBpData(bm)->readoperations;
-}
+    // write the copies in page order, consecutive pages with one call
+    qsort(cleaner->entries, taken, sizeof(FlushEntry), compareFlushEntries);
+    int written = 0;
+    for (int start = 0; start < taken;)
+    {
+        int runLength = flushRunLength(cleaner->entries, start, taken);
+        for (int i = 0; i < runLength; i++)
+        {
+            cleaner->runPages[i] = cleaner->copies + (size_t)cleaner->entries[start + i].frame * pool->pageSize;
+        }
+        // the cleaner's pins keep the file from being detached
+        PoolFile *file = keyFile(pool->files, cleaner->entries[start].pageNum);
+        pthread_rwlock_rdlock(&file->fileLock);
+        bool ok = writeBlocks(keyPage(cleaner->entries[start].pageNum), runLength, &file->fileHandle,
+                              cleaner->runPages) == RC_OK;
+        pthread_rwlock_unlock(&file->fileLock);
+        for (int i = start; i < start + runLength; i++)
+        {
+            cleaner->written[cleaner->entries[i].frame] = ok;
+        }
+        written += ok ? runLength : 0;
+        start += runLength;
+    }
 
-/**
- * Returns the number of write I/O operations performed by the buffer pool.
- * A write operation is performed whenever a page is written to disk.
- */
-int getNumWriteIO(BM_BufferPool *const bm)
-{
-    return getBpData(bm)->writeoperations;
+    // give the frames back; a failed write leaves its frame dirty
+    for (int i = 0; i < taken; i++)
+    {
+        int copy = cleaner->entries[i].frame;
+        BPData *bpData = partitionOf(pool, cleaner->entries[i].pageNum);
+        int frame = cleaner->frames[copy] - bpData->firstFrame;
+
+        pthread_mutex_lock(&bpData->latch);
+        if (cleaner->written[copy])
+        {
+            bpData->writeoperations++;
+        }
+        else if (!bpData->dirtyflag[frame])
+        {
+            bpData->dirtyflag[frame] = true;
+            __atomic_add_fetch(bpData->numDirty, 1, __ATOMIC_RELAXED);
+        }
+        releasePin(&bpData->fixcounts[frame]);
+        if (bpData->lruk != NULL && bpData->fixcounts[frame] == 0)
+        {
+            LRUKunpin(bpData->lruk, frame);
+        }
+        pthread_mutex_unlock(&bpData->latch);
+    }
+    return written;
 }
 
-/**
- * Finds the page number of a page in the cache.
+/*
+ Body of the cleaner thread. It checks the dirty count when markDirty reaches the high
+ watermark and at least every CLEANER_INTERVAL_MS, and stops cleaning early when the
+ remaining dirty frames are all pinned.
  */
-static bool findPageInCache(BPData *bpd, PageNumber pageNum, PageNumber *pgindexbp)
+static void *cleanerThread(void *arg)
 {
-    for (BufferPoolFrame *temp = bpd->headFrame; temp != NULL; temp = temp->nextFrame)
+    BufferPool *pool = (BufferPool *)arg;
+    PageCleaner *cleaner = pool->cleaner;
+
+    pthread_mutex_lock(&cleaner->lock);
+    while (!cleaner->stop)
     {
-        if (temp->indexpage == pageNum)
+        if (__atomic_load_n(&pool->numDirty, __ATOMIC_RELAXED) >= cleaner->highWatermark)
+        {
+            int excess;
+            while ((excess = __atomic_load_n(&pool->numDirty, __ATOMIC_RELAXED) - cleaner->lowWatermark) > 0 &&
+                   cleanRound(pool, excess) > 0)
+            {
+            }
+        }
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += CLEANER_INTERVAL_MS * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+        if (!cleaner->stop)
         {
-            *pgindexbp = temp->indexpool;
-            return true;
+            pthread_cond_timedwait(&cleaner->wake, &cleaner->lock, &deadline);
         }
     }
-    return false;
+    pthread_mutex_unlock(&cleaner->lock);
+    return NULL;
 }
 
 /**
- * Adds a new frame to the cache.
+ * Starts asynchronous reads of up to count pages from firstPage. A page is only read
+ * into a free frame or in place of a clean victim, so prefetching never writes; pages in
+ * the pool or past the end of the file are skipped. The frames are not pinned and can
+ * be evicted again once their reads are done.
  */
-static void addNewFrameToCache(BPData *bpData, PageNumber pageNum, PageNumber pgIndexBP)
+RC prefetchPages(BM_BufferPool *const bm, const PageNumber firstPage, int count)
 {
-    BufferPoolFrame *handle = malloc(sizeof(BufferPoolFrame));
-    handle->indexpool = pgIndexBP;
-    handle->indexpage = pageNum;
-    handle->nextFrame = NULL;
-
-    if (bpData->headFrame == NULL)
+    if (bm == NULL || bm->mgmtData == NULL)
     {
-        bpData->headFrame = bpData->endFrame = handle;
-        handle->prevFrame = NULL;
+        return RC_NULL_PARAM;
     }
-    else
+    if (!((PoolFile *)bm->mgmtData)->hasFile)
     {
-        bpData->endFrame->nextFrame = handle;
-        handle->prevFrame = bpData->endFrame;
-        bpData->endFrame = handle;
+        return RC_FILE_HANDLE_NOT_INIT;
     }
-
-    bpData->listPageNo[pgIndexBP] = pageNum;
-    bpData->pageframesavailable--;
+    if (firstPage < 0 || count < 0)
+    {
+        return RC_ERROR;
+    }
+    BufferPool *pool = getBufferPool(bm);
+    pthread_mutex_lock(&pool->prefetchLock);
+    RC rc = startPrefetches(bm, pool, firstPage, count);
+    pthread_mutex_unlock(&pool->prefetchLock);
+    return rc;
 }
 
-/**
- * This function handles a page that is already in the cache. It changes the page's fix count
- * and points the page handle to the correct page in the cache.
+/*
+ Whether the frame the strategy of a partition would evict next is clean. CLOCK skips the
+ frames whose reference bit gives them a second chance, and comes back to the first
+ unpinned one if all have it; ARC asks REPLACE, which may pick T2 before T1. Needs the
+ prefetch lock for the scratch order and the partition latch.
  */
-void handleCachedPage(BM_BufferPool *const bm, BM_PageHandle *const page, PageNumber pgIndexBP, const PageNumber pageNum, BPData *bpData)
+static bool victimIsClean(BM_BufferPool *const bm, BufferPool *pool, BPData *bpData)
 {
-    if (bm->strategy == RS_LRU)
+    if (bpData->arc != NULL)
+    {
+        // prefetched pages count as unknown to ARC, see takePrefetchFrame
+        int frame = ARCreplaceFrame(bpData->arc, NULL, bpData->arc->target, bpData->fixcounts);
+        return frame != -1 && !bpData->dirtyflag[frame];
+    }
+    int count = evictionOrder(bm->strategy, bpData, pool->prefetchOrder);
+    int firstUnpinned = NO_PAGE;
+    for (int pos = 0; pos < count; pos++)
     {
-        LRUCachePinPage(bm, page, pageNum); // Use pageNum here as well
+        int frame = pool->prefetchOrder[pos];
+        if (__atomic_load_n(&bpData->fixcounts[frame], __ATOMIC_RELAXED) != 0)
+        {
+            continue;
+        }
+        if (bm->strategy == RS_CLOCK && __atomic_load_n(&bpData->refbits[frame], __ATOMIC_RELAXED))
+        {
+            firstUnpinned = firstUnpinned == NO_PAGE ? frame : firstUnpinned;
+            continue;
+        }
+        return !bpData->dirtyflag[frame];
     }
-    page->data = bpData->BpoolData + pgIndexBP * PAGE_SIZE * sizeof(char);
-    bpData->fixcounts[pgIndexBP] = 1;
+    return firstUnpinned != NO_PAGE && !bpData->dirtyflag[firstUnpinned];
 }
 
-/**
- * This function determines which page in the buffer pool should be replaced when a new page is requested.
- * It currently only supports the FIFO and LRU strategies.
+/*
+ Takes a frame of the partition for a prefetch of pageNum and maps the page to it, the
+ frame claimed until the read completes. Returns NO_PAGE if the page is in the pool
+ already or no free or clean frame is left. A prefetch is no miss of ARC: the page's
+ ghost is forgotten, so the target does not move and the page goes to T1, as any page
+ nobody has used yet. Needs the prefetch lock and the latch.
  */
-PageNumber selectPageReplacementFrame(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum, SM_FileHandle *sm_fileHandle)
+static int takePrefetchFrame(BM_BufferPool *const bm, BufferPool *pool, BPData *bpData, PageNumber pageNum)
 {
-    if (bm->strategy == RS_FIFO || bm->strategy == RS_LRU)
+    int frame;
+    if (findPageInBuffer(bpData, pageNum, bpData->numFrames) != NO_PAGE)
+    {
+        return NO_PAGE;
+    }
+    if (bpData->pageframesavailable == 0 && !victimIsClean(bm, pool, bpData))
+    {
+        return NO_PAGE;
+    }
+    if (bpData->arc != NULL)
+    {
+        ARCforget(bpData->arc, pageNum);
+    }
+    if (bpData->pageframesavailable > 0)
     {
-        return LRUpinPageFIFO(bm, page, pageNum, sm_fileHandle);
+        frame = bpData->numFrames - bpData->pageframesavailable;
+        addNewFrameToCache(bpData, pageNum, frame);
     }
     else
     {
-        printf("\n \n \t \t \t \t \t \t Other Page Replacement Strategies are not available\n");
-        return NO_PAGE; // Return a default value if no strategy is available
+        frame = selectPageReplacementFrame(bm, bpData, pageNum);
+        if (frame == NO_PAGE)
+        {
+            return NO_PAGE;
+        }
+        __atomic_store_n(&bpData->fixcounts[frame], FRAME_CLAIMED, __ATOMIC_RELAXED);
+    }
+
+    // LRU-K and LFU take the frame back when the read completes
+    if (bpData->lruk != NULL)
+    {
+        LRUKrestoreHistory(bpData->lruk, frame, pageNum);
     }
+    if (bpData->arc != NULL)
+    {
+        ARCmoveFrame(bpData->arc, frame, &bpData->arc->t1);
+    }
+    return frame;
 }
 
-/**
- * This function gets a page from the buffer pool for the given page number. If the page is already there,
- * it brings it to front. If not, it selects a new frame and that page is read from disk to the frame.
- * The frame is then added to the cache.
+/*
+ Hands a prefetched frame (an index over the whole pool) over to the pool: from now on it
+ can be pinned and evicted like any other. A failed asynchronous read is retried
+ synchronously; if that fails too, the frame is vacated as after a failed pin and the
+ page's LRU-K history is given back.
  */
-RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+static void finishPrefetch(BufferPool *pool, int frame, RC status)
 {
-    // Check for null pointers
-    if (bm == NULL || page == NULL)
-    {
-        return RC_NULL_PARAM; // Define this error code as needed
-    }
+    // the claim keeps the frame's page in place
+    PageNumber key = __atomic_load_n(&pool->listPageNo[frame], __ATOMIC_ACQUIRE);
+    BPData *bpData = partitionOf(pool, key);
+    frame -= bpData->firstFrame;
 
-    // Open page file
-    SM_FileHandle sm_fileHandle;
-    RC status = openPageFile(bm->pageFile, &sm_fileHandle);
+    pthread_mutex_lock(&bpData->latch);
     if (status != RC_OK)
     {
-        return RC_FILE_NOT_FOUND;
+        PoolFile *file = keyFile(pool->files, key);
+        pthread_rwlock_rdlock(&file->fileLock);
+        status = readBlockAt(keyPage(key), &file->fileHandle, frameData(bpData, frame));
+        pthread_rwlock_unlock(&file->fileLock);
+        if (status != RC_OK)
+        {
+            if (bpData->lruk != NULL)
+            {
+                LRUKretainHistory(bpData->lruk, frame, key);
+            }
+            vacateFrame(bpData, frame);
+            pthread_mutex_unlock(&bpData->latch);
+            return;
+        }
     }
-
-    // Ensure the page file has enough space for the requested page number
-    if (sm_fileHandle.totalNumPages <= pageNum)
+    bpData->readoperations++;
+    // under CLOCK the page survives one sweep, so later prefetches do not push it out unused
+    __atomic_store_n(&bpData->refbits[frame], true, __ATOMIC_RELAXED);
+    if (bpData->lruk != NULL)
     {
-        ensureCapacity(pageNum + 1, &sm_fileHandle);
+        LRUKunpin(bpData->lruk, frame);
     }
+    if (bpData->lfu != NULL)
+    {
+        LFUtouch(bpData->lfu, frame);
+    }
+    __atomic_store_n(&bpData->fixcounts[frame], 0, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&bpData->latch);
+}
 
-    page->pageNum = pageNum;
-    BPData *bpData = (BPData *)bm->mgmtData;
-    PageNumber pgIndexBP = NO_PAGE;
-
-    // Check if the page is in the cache
-    bool isPageInCache = findPageInCache(bpData, pageNum, &pgIndexBP);
+/*
+ Common body of prefetchPages and read-ahead; the caller holds the prefetch lock. Stops
+ early when PREFETCH_QUEUE_DEPTH reads are in flight.
+ */
+static RC startPrefetches(BM_BufferPool *const bm, BufferPool *pool, PageNumber firstPage, int count)
+{
+    if (pool->aio == NULL)
+    {
+        // the first partition is never smaller than the others
+        pool->prefetchOrder = (int *)malloc(pool->partitions[0].numFrames * sizeof(int));
+        if (pool->prefetchOrder == NULL)
+        {
+            return RC_MEM_ALLOC_FAILURE;
+        }
+        RC rc = initAsyncIO(&pool->aio, PREFETCH_QUEUE_DEPTH);
+        if (rc != RC_OK)
+        {
+            free(pool->prefetchOrder);
+            pool->prefetchOrder = NULL;
+            pool->aio = NULL;
+            return rc;
+        }
+    }
+    collectPrefetches(pool, false);
 
-    if (isPageInCache)
+    PoolFile *file = (PoolFile *)bm->mgmtData;
+    pthread_rwlock_rdlock(&file->fileLock);
+    PageNumber endPage = file->fileHandle.totalNumPages < firstPage + count ? file->fileHandle.totalNumPages
+                                                                             : firstPage + count;
+    pthread_rwlock_unlock(&file->fileLock);
+    // as in pinPage, pages past the key's page bits are not cached
+    if (endPage > (PageNumber)1 << POOL_PAGE_BITS)
     {
-        handleCachedPage(bm, page, pgIndexBP, pageNum, bpData);
+        endPage = (PageNumber)1 << POOL_PAGE_BITS;
     }
-    else
+
+    int started = 0;
+    for (PageNumber pageNum = firstPage; pageNum < endPage && pool->prefetchesInFlight < PREFETCH_QUEUE_DEPTH; pageNum++)
     {
-        // If not in cache, try to add it to the buffer pool
-        if (bpData->pageframesavailable > 0)
+        PageNumber key = pageKey(file, pageNum);
+        BPData *bpData = partitionOf(pool, key);
+        pthread_mutex_lock(&bpData->latch);
+        int frame = takePrefetchFrame(bm, pool, bpData, key);
+        if (frame != NO_PAGE)
         {
-            pgIndexBP = bm->numPages - bpData->pageframesavailable; // Adjust based on your structure
-            addNewFrameToCache(bpData, pageNum, pgIndexBP);
+            // counted before the latch is released, so pins of the page know to wait
+            __atomic_add_fetch(&pool->prefetchesInFlight, 1, __ATOMIC_RELAXED);
         }
-        else
+        pthread_mutex_unlock(&bpData->latch);
+        if (frame == NO_PAGE)
         {
-            // Select a frame based on buffer pool strategy
-            pgIndexBP = selectPageReplacementFrame(bm, page, pageNum, &sm_fileHandle);
+            continue;
         }
 
-        // Ensure pgIndexBP is valid
-        // Check against available frames in bpData
-        if (pgIndexBP < 0 || pgIndexBP >= (bm->numPages - bpData->pageframesavailable))
+        // the claimed frame keeps everyone else away while the read runs
+        frame += bpData->firstFrame;
+        if (submitReadBlock(pool->aio, pageNum, &file->fileHandle, pool->BpoolData + (size_t)frame * pool->pageSize,
+                            (void *)(long)frame) == RC_OK)
         {
-            return RC_PAGE_NOT_FOUND_IN_CACHE; // Handle this error appropriately
+            started++;
         }
-
-        // Read the page from disk
-        if (readBlock(page->pageNum, &sm_fileHandle, bpData->BpoolData + pgIndexBP * PAGE_SIZE * sizeof(char)) != RC_OK)
+        else
         {
-            return RC_FILE_NOT_FOUND; // Handle read failure appropriately
+            finishPrefetch(pool, frame, RC_ERROR);
+            __atomic_sub_fetch(&pool->prefetchesInFlight, 1, __ATOMIC_RELAXED);
         }
-        bpData->readoperations++;
     }
-
-    // Set page data and fix count
-    page->data = bpData->BpoolData + pgIndexBP * PAGE_SIZE * sizeof(char);
-    bpData->fixcounts[pgIndexBP] = 1;
-
-    closePageFile(&sm_fileHandle);
+    if (started > 0)
+    {
+        startAsyncIO(pool->aio);
+    }
     return RC_OK;
 }
 
 /*
- Here we get a page from the buffer pool for the page number and if it's there we bring it to the front.
- Else, we get a new frame, where the page is read from disk to the frame. We then add it to cache.
+ Collects finished prefetches and hands their frames over; with 'wait' it blocks until at
+ least one read finished, unless none is in flight. Returns the number collected, -1 if
+ the engine failed. The caller holds the prefetch lock.
  */
-PageNumber LRUpinPageFIFO(BM_BufferPool *const bm, BM_PageHandle *const page,
-                          const PageNumber pageNum, SM_FileHandle *fileHandle)
+static int collectPrefetches(BufferPool *pool, bool wait)
 {
-    BPData *bpData = (BPData *)bm->mgmtData;
-    PageNumber bufferPoolPageIndex = NO_PAGE;
-
-    BufferPoolFrame *temp = firstframefind(bpData);
-
-    if (temp)
+    SM_IOCompletion done[PREFETCH_QUEUE_DEPTH];
+    if (pool->aio == NULL || pool->prefetchesInFlight == 0)
     {
-        reorder(bpData, temp);
-        dirtypageneeded(bpData, fileHandle);
-        updatenewpg(bpData, pageNum);
+        return 0;
+    }
+    int numDone = wait ? waitAsyncIO(pool->aio, done, PREFETCH_QUEUE_DEPTH)
+                       : pollAsyncIO(pool->aio, done, PREFETCH_QUEUE_DEPTH);
+    for (int i = 0; i < numDone; i++)
+    {
+        finishPrefetch(pool, (int)(long)done[i].tag, done[i].status);
+        __atomic_sub_fetch(&pool->prefetchesInFlight, 1, __ATOMIC_RELAXED);
+    }
+    return numDone;
+}
 
-        bufferPoolPageIndex = bpData->endFrame->indexpool;
+// Collects finished prefetches if no other thread is doing so already
+static void pollPrefetches(BufferPool *pool)
+{
+    if (pthread_mutex_trylock(&pool->prefetchLock) == 0)
+    {
+        collectPrefetches(pool, false);
+        pthread_mutex_unlock(&pool->prefetchLock);
     }
+}
 
-    return bufferPoolPageIndex;
+// Waits for all prefetches in flight; frames being read are neither pinned nor free
+static void drainPrefetches(BufferPool *pool)
+{
+    pthread_mutex_lock(&pool->prefetchLock);
+    while (pool->prefetchesInFlight > 0 && collectPrefetches(pool, true) > 0)
+    {
+    }
+    pthread_mutex_unlock(&pool->prefetchLock);
 }
 
 /*
-Find the first frame in the buffer pool that's unpinned.
-If none, return NULL.
+ Whether pageNum is mapped to a frame whose prefetch has not completed; the caller holds
+ the partition latch. Loads and evictions claim frames only while holding the latch, so
+ a claimed frame seen under it is always being prefetched.
  */
-static BufferPoolFrame *firstframefind(BPData *bpData)
+static bool prefetchInFlight(BufferPool *pool, BPData *bpData, PageNumber pageNum)
 {
-    BufferPoolFrame *temp = bpData->headFrame;
-    while (temp)
+    if (__atomic_load_n(&pool->prefetchesInFlight, __ATOMIC_RELAXED) == 0)
     {
-        if (bpData->fixcounts[temp->indexpool] == 0)
-        {
-            return temp;
-        }
-        temp = temp->nextFrame;
+        return false;
     }
-    return NULL;
+    int frame = findPageInBuffer(bpData, pageNum, bpData->numFrames);
+    return frame != NO_PAGE && __atomic_load_n(&bpData->fixcounts[frame], __ATOMIC_ACQUIRE) == FRAME_CLAIMED;
 }
 
 /*
- Reorders the frames' linked list. This function takes a frame found as an arg
- and puts it at the end of the list
+ Read-ahead: after READ_AHEAD_TRIGGER pins of consecutive pages (pinning the same page
+ again keeps the run going), the next readAhead pages are prefetched, and again whenever
+ the run has used up half of them. The bookkeeping is racy on purpose; concurrent runs
+ only make read-ahead start later or earlier.
  */
-static void reorder(BPData *bpData, BufferPoolFrame *temp)
+static void detectSequential(BM_BufferPool *const bm, PoolFile *file, PageNumber pageNum)
 {
-    // if the frame is not already at the end of the list
-    if (temp != bpData->endFrame)
+    BufferPool *pool = file->pool;
+    PageNumber last = __atomic_exchange_n(&file->lastPinned, pageNum, __ATOMIC_RELAXED);
+    if (pageNum == last)
     {
-        // move  frame to end of list
-        bpData->endFrame->nextFrame = temp;
-
-        temp->nextFrame->prevFrame = temp->prevFrame;
-
-        if (temp == bpData->headFrame)
-        {
-            bpData->headFrame = bpData->headFrame->nextFrame;
-        }
-        else
-        {
-            // update next one
-            temp->prevFrame->nextFrame = temp->nextFrame;
-        }
+        return;
+    }
+    if (last == NO_PAGE || pageNum != last + 1)
+    {
+        __atomic_store_n(&file->runLength, 0, __ATOMIC_RELAXED);
+        return;
+    }
+    if (__atomic_add_fetch(&file->runLength, 1, __ATOMIC_RELAXED) + 1 < READ_AHEAD_TRIGGER)
+    {
+        return;
+    }
 
-        // update previous, next pointers
-        temp->prevFrame = bpData->endFrame;
-        bpData->endFrame = bpData->endFrame->nextFrame;
-        bpData->endFrame->nextFrame = NULL;
+    // an end outside the window is left over from another run
+    PageNumber windowEnd = pageNum + 1 + pool->readAhead;
+    PageNumber end = __atomic_load_n(&file->readAheadEnd, __ATOMIC_RELAXED);
+    bool inWindow = end > pageNum && end <= windowEnd;
+    if (inWindow && end > pageNum + pool->readAhead / 2)
+    {
+        return;
+    }
+    PageNumber from = inWindow ? end : pageNum + 1;
+    if (pthread_mutex_trylock(&pool->prefetchLock) != 0)
+    {
+        return; // another pin is reading ahead
     }
+    __atomic_store_n(&file->readAheadEnd, windowEnd, __ATOMIC_RELAXED);
+    startPrefetches(bm, pool, from, windowEnd - from);
+    pthread_mutex_unlock(&pool->prefetchLock);
 }
 
 /*
  write dirty page to disk and mark as clean
  */
-static void dirtypageneeded(BPData *bpData, SM_FileHandle *fileHandle)
+static void dirtypageneeded(BPData *bpData, BufferPoolFrame *frame)
 {
-    if (bpData->dirtyflag[bpData->endFrame->indexpool] == true)
+    if (bpData->dirtyflag[frame->indexpool] == true)
     {
         // Point to data for page
-        char *memory = bpData->BpoolData +
-                       bpData->endFrame->indexpool * PAGE_SIZE * sizeof(char);
-        // dirty page no.
-        int oldPgNum = bpData->endFrame->indexpage;
+        char *memory = frameData(bpData, frame->indexpool);
+        // dirty page no. and the file it belongs to
+        PageNumber oldPgNum = frame->indexpage;
+        PoolFile *file = keyFile(bpData->files, oldPgNum);
         // write to disk
-        writeBlock(oldPgNum, fileHandle, memory);
+        pthread_rwlock_rdlock(&file->fileLock);
+        writeBlock(keyPage(oldPgNum), &file->fileHandle, memory);
+        pthread_rwlock_unlock(&file->fileLock);
         // Mark clean
-        bpData->dirtyflag[bpData->endFrame->indexpool] = false;
+        bpData->dirtyflag[frame->indexpool] = false;
+        __atomic_sub_fetch(bpData->numDirty, 1, __ATOMIC_RELAXED);
         bpData->writeoperations++;
     }
 }
 
 /*
- Update end frame of linked list for new page no.
+ Update a frame of linked list for new page no.
  */
-static void updatenewpg(BPData *bpData, PageNumber pageNum)
+static void updatenewpg(BPData *bpData, BufferPoolFrame *frame, PageNumber pageNum)
 {
-    bpData->endFrame->indexpage = pageNum;
-    bpData->listPageNo[bpData->endFrame->indexpool] = pageNum;
+    // a frame emptied by a failed read has no page to drop
+    if (frame->indexpage != NO_PAGE)
+    {
+        pageTableRemove(&bpData->pageTable, frame->indexpage);
+    }
+    pageTableInsert(&bpData->pageTable, pageNum, frame->indexpool);
+    frame->indexpage = pageNum;
+    __atomic_store_n(&bpData->listPageNo[frame->indexpool], pageNum, __ATOMIC_RELEASE);
 }
 
-void LRUCachePinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+void LRUCachePinPage(BPData *bpData, const PageNumber pageNum)
 {
-    BPData *bpData = (BPData *)bm->mgmtData;
-    BufferPoolFrame *currentFrame = bpData->headFrame;
     BufferPoolFrame *endFrame = bpData->endFrame;
 
     // Find frame w/ page no.
-    while (currentFrame != NULL && currentFrame->indexpage != pageNum)
-    {
-        currentFrame = currentFrame->nextFrame;
-    }
+    int frame = pageTableLookup(&bpData->pageTable, pageNum);
+    BufferPoolFrame *currentFrame = frame == NO_PAGE ? NULL : bpData->frameNodes[frame];
 
     if (currentFrame != NULL && currentFrame != endFrame)
     {
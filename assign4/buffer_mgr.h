@@ -13,13 +13,17 @@ typedef enum ReplacementStrategy {
 	RS_LRU = 1,
 	RS_CLOCK = 2,
 	RS_LFU = 3,
-	RS_LRU_K = 4
+	RS_LRU_K = 4,
+	RS_ARC = 5	// adaptive replacement cache: balances recency and frequency on its own
 } ReplacementStrategy;
 
 // Data Types and Structures
-typedef int PageNumber;
 #define NO_PAGE -1
 
+// PageNumber is 64 bit (dt.h), but a buffer pool caches pages below 2^BM_PAGE_BITS only:
+// the bits above hold the id of the page's file. Pinning a page past them fails.
+#define BM_PAGE_BITS 40
+
 typedef struct BM_BufferPool {
 	char *pageFile;
 	int numPages;
@@ -28,9 +32,31 @@ typedef struct BM_BufferPool {
 	// manager needs for a buffer pool
 } BM_BufferPool;
 
+// Optional pool settings for initBufferPoolWithOptions (NULL means defaults)
+typedef struct BM_PoolOptions {
+	bool directIO; // read/write the page file with O_DIRECT so the pool is the only cache
+	int numPartitions; // frames split into this many independently latched partitions (0 means 1)
+	bool backgroundCleaner; // a writer thread cleans dirty unpinned frames ahead of eviction
+	int dirtyHighWatermark; // percent of frames dirty that wakes the cleaner (0 means 50)
+	int dirtyLowWatermark; // percent of frames dirty it writes down to (0 means 25)
+	int readAheadPages; // pages read ahead once pins walk through consecutive pages (0 means off)
+	bool hugePages; // back the frames with huge pages where the system offers them, for fewer TLB misses
+	bool prefaultFrames; // fault all frame memory in at init rather than on first use
+	bool warmRestart; // save the cached pages to <pageFile>.warm at shutdown and reload them at init
+} BM_PoolOptions;
+
+// Latch a pin holds on its frame: none (plain pinPage), shared or exclusive
+typedef enum BM_PinMode {
+	PIN_NONE = 0,
+	PIN_READ = 1,
+	PIN_WRITE = 2
+} BM_PinMode;
+
 typedef struct BM_PageHandle {
 	PageNumber pageNum;
 	char *data;
+	BM_PinMode mode; // set by the pin functions, unpinPage releases the latch it names
+	int pageSize; // bytes at data, the page size of the pool's file; set by the pin functions
 } BM_PageHandle;
 
 // convenience macros
@@ -41,12 +67,37 @@ typedef struct BM_PageHandle {
 		((BM_PageHandle *) malloc (sizeof(BM_PageHandle)))
 
 // Buffer Manager Interface Pool Handling
+// stratData: for RS_LRU_K a pointer to an int K (NULL means K = 1, i.e. plain LRU),
+// for RS_LFU a pointer to an int aging interval in pins (NULL or 0 means no aging)
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
 		const int numPages, ReplacementStrategy strategy,
 		void *stratData);
+RC initBufferPoolWithOptions(BM_BufferPool *const bm, const char *const pageFileName,
+		const int numPages, ReplacementStrategy strategy,
+		void *stratData, const BM_PoolOptions *options);
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
 
+// Shared pools: one set of frames (of PAGE_SIZE) for the pages of many page files, so hot
+// files get more of them and cold ones fewer. attachPageFile makes 'bm' a handle of a file
+// in the shared pool, usable with every other function like a pool of its own, and
+// shutdownBufferPool(bm) detaches the file again. The shared pool's own handle pins no
+// pages; its statistics cover all attached files, and it can only be shut down after the
+// last file is detached.
+RC initSharedBufferPool(BM_BufferPool *const bm, const int numPages,
+		ReplacementStrategy strategy, void *stratData,
+		const BM_PoolOptions *options);
+RC attachPageFile(BM_BufferPool *const bm, BM_BufferPool *const sharedPool,
+		const char *const pageFileName);
+
+// Changes the number of frames of a pool while it keeps its pages. Growing adds free
+// frames; shrinking evicts the pages the replacement strategy would evict first, writing
+// the dirty ones, and the strategy keeps what it knew about the rest. Only the handle
+// that created the pool can resize it, never while pages are pinned, and no other
+// thread may use the pool meanwhile. Arrays returned by the statistics functions
+// before are no longer valid.
+RC resizeBufferPool(BM_BufferPool *const bm, const int newNumPages);
+
 // Buffer Manager Interface Access Pages
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page);
@@ -54,11 +105,34 @@ RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
 		const PageNumber pageNum);
 
+// Pins that also latch the frame: any number of readers share a page, a writer has it
+// to itself. The latch is held until unpinPage. A thread must not pin a page for write
+// while it holds another pin with a latch on the same page.
+RC pinPageForRead (BM_BufferPool *const bm, BM_PageHandle *const page,
+		const PageNumber pageNum);
+RC pinPageForWrite (BM_BufferPool *const bm, BM_PageHandle *const page,
+		const PageNumber pageNum);
+
+// Scan rings: a sequential scan pins through a ring of a few frames that it recycles,
+// so it does not push the rest of the pool out. The ring belongs to one pool and must
+// be freed before the pool is shut down.
+typedef struct BM_ScanRing BM_ScanRing;
+RC createScanRing (BM_BufferPool *const bm, int numFrames, BM_ScanRing **ring);
+RC freeScanRing (BM_ScanRing *ring);
+RC pinPageWithRing (BM_BufferPool *const bm, BM_PageHandle *const page,
+		const PageNumber pageNum, BM_ScanRing *ring);
+
+// Starts reads of up to count pages from firstPage into free frames, or frames whose
+// page is clean, without pinning them; pages already in the pool or past the end of the
+// file are skipped. A later pin of the page waits for its read if it is still running.
+RC prefetchPages (BM_BufferPool *const bm, const PageNumber firstPage, int count);
+
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
 bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+int getPoolPageSize (BM_BufferPool *const bm);
 
 #endif
@@ -4,6 +4,7 @@
 #include "stdio.h"
 
 /* module wide constants */
+// default (and smallest) page size, see createPageFileWithPageSize for larger pages
 #define PAGE_SIZE 4096
 
 /* return code definitions */
@@ -32,6 +33,11 @@ typedef int RC;
 #define RC_RM_NO_RECORD_FOUND 16
 #define RC_PAGE_NOT_FOUND_IN_CACHE 17
 #define RC_SHUTDOWN_POOL_ERROR 18
+#define RC_ASYNC_QUEUE_FULL 19
+#define RC_PAGE_PINNED_FOR_READ 20
+#define RC_POOL_HAS_PINNED_PAGES 21
+#define RC_READ_FAILED 22
+#define RC_PAGE_ALREADY_FREE 23
 
 #define RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE 200
 #define RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN 201
@@ -11,4 +11,7 @@
 #define TRUE true
 #define FALSE false
 
+// page numbers are 64 bit so page counts and file offsets of large page files never overflow
+typedef long long PageNumber;
+
 #endif // DT_H
@@ -13,46 +13,66 @@
 #define DELIMITER_FIRST_ATTR '|'
 #define DELIMITER_OTHER_ATTR ','
 #define MAX_KEY_ATTRS 100
+#define SCAN_RING_FRAMES 4 // frames a scan may recycle, capped by the pool size
 
 static char pageFile[MAX_PAGE_FILE_NAME];
 
+// shared buffer pool the tables are attached to, NULL gives every table a pool of its own
+static BM_BufferPool *sharedPool = NULL;
+
 static bool parseSchemaHeader(char *schemaCopy, char **token, char **context, Schema *schema);
 static bool allocateSchemaMemory(Schema *schema);
 static bool parseAttributes(char **token, char **context, Schema *schema);
 static bool parseDataType(char *typeStr, DataType *dataType, int *typeLength);
 static bool parseKeyAttributes(char **token, char **context, Schema *schema);
+static RC readRecord(RM_TableData *rel, RID id, Record *record, BM_ScanRing *ring);
 
 typedef struct ScanData
 {
     /*page info */
-    int thisPage;
-    int numOfPages;
+    PageNumber thisPage;
+    PageNumber numOfPages;
 
     /*slot info */
     int thisSlot;
     int totalNumSlots;
 
     Expr *theCondition;
+
+    /* frames the scan reads through, keeps it from flushing the table's pool */
+    BM_ScanRing *ring;
 } ScanData;
 
 RC initRecordManager(void *mgmtData)
 {
     // This function initializes the record manager
-    // The parameter `mgmtData` is a placeholder for managing data that might be needed for initialization.
+    // The parameter `mgmtData` may point to a shared buffer pool (initSharedBufferPool);
+    // tables opened from then on keep their pages there instead of in a pool of their own.
     // Here, the function returns RC_OK.
+    sharedPool = (BM_BufferPool *)mgmtData;
     return RC_OK;
 }
 
 /**
  * This function eleases any resources that the record manager
- *allocated. Nothing right now.
+ *allocated. The shared pool, if any, belongs to the caller.
  */
 RC shutdownRecordManager()
 {
+    sharedPool = NULL;
     return RC_OK;
 }
 
 RC createTable(char *name, Schema *schema)
+{
+    return createTableWithPageSize(name, schema, PAGE_SIZE);
+}
+
+/**
+ * Creates a table whose page file uses 'pageSize' byte pages. Slot math of the
+ * other record manager functions follows the page size stored in the file.
+ */
+RC createTableWithPageSize(char *name, Schema *schema, int pageSize)
 {
     RC rc;
     SM_FileHandle fileHandle;
@@ -71,7 +91,7 @@ RC createTable(char *name, Schema *schema)
     pageFile[MAX_PAGE_FILE_NAME - 1] = '\0';
 
     /* Create a new page file. The page file is empty to begin with */
-    rc = createPageFile(name);
+    rc = createPageFileWithPageSize(name, pageSize);
     if (rc != RC_OK)
     {
         return rc;
@@ -100,8 +120,17 @@ RC createTable(char *name, Schema *schema)
         return RC_SERIALIZATION_ERROR;
     }
 
-    /* Write the serialized schema to the page. */
-    rc = writeBlock(0, &fileHandle, schemaToString);
+    /* Copy the serialized schema into a full page and write it to page 0. */
+    char *schemaPage = calloc(fileHandle.pageSize, sizeof(char));
+    if (schemaPage == NULL)
+    {
+        free(schemaToString);
+        closePageFile(&fileHandle);
+        return RC_MEM_ALLOC_FAILURE;
+    }
+    strncpy(schemaPage, schemaToString, fileHandle.pageSize - 1);
+    rc = writeBlock(0, &fileHandle, schemaPage);
+    free(schemaPage);
     free(schemaToString);
 
     if (rc != RC_OK)
@@ -344,8 +373,8 @@ RC openTable(RM_TableData *rel, char *name)
         return RC_MEM_ALLOC_FAILURE;
 
     RC rc;
-    // Init the buffer pool
-    rc = initBufferPool(bm, name, 3, RS_FIFO, NULL);
+    // Init the buffer pool, or attach the table to the shared one
+    rc = sharedPool != NULL ? attachPageFile(bm, sharedPool, name) : initBufferPool(bm, name, 3, RS_FIFO, NULL);
     if (rc != RC_OK)
         goto cleanup;
 
@@ -444,7 +473,9 @@ int getNumTuples(RM_TableData *rel)
         return -1;
     }
 
-    int blockNum = 1, totalRecord = 0;
+    PageNumber blockNum = 1;
+    int totalRecord = 0;
+    int pageSize = getPoolPageSize(bm);
     // Iterate through all pages
     while (blockNum < fileHandle.totalNumPages)
     {
@@ -455,7 +486,7 @@ int getNumTuples(RM_TableData *rel)
             return -1;
         }
         // Count records in the page
-        for (int i = 0; i < PAGE_SIZE; i++)
+        for (int i = 0; i < pageSize; i++)
         {
             if (pageHandle.data[i] == '|')
                 totalRecord++;
@@ -467,14 +498,14 @@ int getNumTuples(RM_TableData *rel)
     return totalRecord;
 }
 
-int getUsedPageSpace(char *pageData, Schema *schema)
+int getUsedPageSpace(char *pageData, Schema *schema, int pageSize)
 {
     int spaceused = 0;
     int offset = 0;
     int recsize = getRecordSize(schema);
 
     // Iterate through the page data and calculate used space
-    while (offset < PAGE_SIZE)
+    while (offset < pageSize)
     {
         // Check for valid record
         if (pageData[offset] != '\0')
@@ -508,17 +539,18 @@ RC insertRecord(RM_TableData *rel, Record *record)
     {
         return RC_FILE_NOT_FOUND;
     }
-    int NumberPagetotal = fileHandle.totalNumPages;
+    PageNumber NumberPagetotal = fileHandle.totalNumPages;
     closePageFile(&fileHandle);
 
     int recsize = getRecordSize(rel->schema);
+    int pageSize = getPoolPageSize(bm);
 
     // Find space for the new record
     while (NoofPage <= NumberPagetotal)
     {
         pinPage(bm, &pageHandle, NoofPage);
-        pgLen = getUsedPageSpace(pageHandle.data, rel->schema);
-        int spaceleft = PAGE_SIZE - pgLen;
+        pgLen = getUsedPageSpace(pageHandle.data, rel->schema, pageSize);
+        int spaceleft = pageSize - pgLen;
 
         if (recsize <= spaceleft)
         {
@@ -534,7 +566,7 @@ RC insertRecord(RM_TableData *rel, Record *record)
     // Insert the record
     pinPage(bm, &pageHandle, NoofPage);
     char *dtptr = pageHandle.data;
-    pgLen = getUsedPageSpace(dtptr, rel->schema);
+    pgLen = getUsedPageSpace(dtptr, rel->schema, pageSize);
     char *recPtr = dtptr + pgLen;
     strcpy(recPtr, record->data);
     markDirty(bm, &pageHandle);
@@ -628,6 +660,14 @@ RC updateRecord(RM_TableData *rel, Record *record)
 }
 
 RC getRecord(RM_TableData *rel, RID id, Record *record)
+{
+    return readRecord(rel, id, record, NULL);
+}
+
+/**
+ * Copies a record out of its page. Scans pass their ring so the page is read through it.
+ */
+static RC readRecord(RM_TableData *rel, RID id, Record *record, BM_ScanRing *ring)
 {
     // Check for null params
     if (rel == NULL)
@@ -653,7 +693,7 @@ RC getRecord(RM_TableData *rel, RID id, Record *record)
     int recSize = getRecordSize(rel->schema);
 
     // Pin the page
-    RC pinRC = pinPage(bm, pageHandle, pageNum);
+    RC pinRC = ring != NULL ? pinPageWithRing(bm, pageHandle, pageNum, ring) : pinPage(bm, pageHandle, pageNum);
     if (pinRC != RC_OK)
     {
         free(pageHandle);
@@ -685,8 +725,8 @@ RC getRecord(RM_TableData *rel, RID id, Record *record)
 
 RC startScan(RM_TableData *rel, RM_ScanHandle *scan, Expr *condition)
 {
-    // Check for null inputs
-    if (rel == NULL || scan == NULL || condition == NULL)
+    // Check for null inputs; without a condition the scan returns every record
+    if (rel == NULL || scan == NULL)
     {
         return RC_ERROR;
     }
@@ -698,7 +738,8 @@ RC startScan(RM_TableData *rel, RM_ScanHandle *scan, Expr *condition)
     {
         return rc;
     }
-    int totalNumPages = fileHandle.totalNumPages;
+    PageNumber totalNumPages = fileHandle.totalNumPages;
+    int pageSize = fileHandle.pageSize;
     closePageFile(&fileHandle);
 
     // Calculate slots per page
@@ -707,7 +748,7 @@ RC startScan(RM_TableData *rel, RM_ScanHandle *scan, Expr *condition)
     {
         return RC_ERROR;
     }
-    int totNumSlots = PAGE_SIZE / recsize;
+    int totNumSlots = pageSize / recsize;
 
     // Initialize scan data
     ScanData *scanDataInfo = (ScanData *)malloc(sizeof(ScanData));
@@ -722,6 +763,13 @@ RC startScan(RM_TableData *rel, RM_ScanHandle *scan, Expr *condition)
         .totalNumSlots = totNumSlots,
         .theCondition = condition};
 
+    rc = createScanRing((BM_BufferPool *)rel->mgmtData, SCAN_RING_FRAMES, &scanDataInfo->ring);
+    if (rc != RC_OK)
+    {
+        free(scanDataInfo);
+        return rc;
+    }
+
     (*scan).rel = rel;
     (*scan).mgmtData = scanDataInfo;
 
@@ -762,7 +810,7 @@ RC next(RM_ScanHandle *scan, Record *record)
         record->id.slot = scaninformation->thisSlot;
 
         // Get record
-        rc = getRecord(scan->rel, record->id, record);
+        rc = readRecord(scan->rel, record->id, record, scaninformation->ring);
         if (rc != RC_OK)
         {
             return rc;
@@ -791,6 +839,18 @@ RC next(RM_ScanHandle *scan, Record *record)
 
         freeVal(idValue); // Free after check
 
+        // Without a condition every record qualifies
+        if (scaninformation->theCondition == NULL)
+        {
+            scaninformation->thisSlot++;
+            if (scaninformation->thisSlot >= scaninformation->totalNumSlots)
+            {
+                scaninformation->thisSlot = 0;
+                scaninformation->thisPage++;
+            }
+            return RC_OK;
+        }
+
         // Evaluate condition
         rc = evalExpr(
             record,
@@ -830,6 +890,7 @@ RC closeScan(RM_ScanHandle *scan)
     }
 
     // Free scan management data
+    freeScanRing(((ScanData *)scan->mgmtData)->ring);
     free(scan->mgmtData);
     scan->mgmtData = NULL;
 
@@ -1,7 +1,224 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // O_DIRECT
+#endif
 #include "stdio.h"
 #include "stdlib.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <limits.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+#include <string.h>
+#include "dt.h"
 #include "storage_mgr.h"
 
+/* Page files start with a header block (superblock) recording the page size, the page
+   count and the head of the free-page list; page 0 follows it. The block is a multiple
+   of the OS page size so mmap and O_DIRECT offsets stay aligned. Freed pages are
+   chained through their first PageNumber. Files without this header, or with another
+   version of it, are not opened. */
+#define SM_HEADER_SIZE 4096
+#define SM_HEADER_MAGIC "SMPGFILE"
+#define SM_HEADER_VERSION 4
+
+typedef struct SM_FileHeader
+{
+    char magic[8];
+    int version;
+    int pageSize;
+    PageNumber pageCount;
+    PageNumber freeListHead; // -1 when no page is free
+    PageNumber freePageCount;
+} SM_FileHeader;
+
+/* Per-file state kept behind SM_FileHandle->mgmtInfo. Pages are read and written with
+   pread/pwrite at their offset, so there is no shared seek position and several
+   threads can issue I/O on one handle at the same time. */
+typedef struct SM_FileInfo
+{
+    int fd;
+    SM_OpenMode mode;
+    // page size of this file; page 0 starts after the header block
+    int pageSize;
+    // pages reserved on disk (>= totalNumPages) and the growth step used to reserve them
+    PageNumber allocatedPages;
+    int extentPages;
+    // SM_MODE_MMAP only: shared mapping of the whole file, NULL while the file is empty
+    char *map;
+    size_t mapSize;
+    // free-page list, mirrored in the superblock (files with a header only)
+    PageNumber freeListHead;
+    PageNumber freePageCount;
+} SM_FileInfo;
+
+static bool preadFull(int fd, char *buf, size_t size, off_t offset);
+static bool pwriteFull(int fd, const char *buf, size_t size, off_t offset);
+
+// Returns the descriptor of an open handle, or -1 if the handle is not initialized.
+static int fileDescriptor(SM_FileHandle *fHandle)
+{
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL)
+    {
+        return -1;
+    }
+    return ((SM_FileInfo *)fHandle->mgmtInfo)->fd;
+}
+
+// Byte offset of a page in the file.
+static off_t pageOffset(SM_FileInfo *fileInfo, PageNumber pageNum)
+{
+    return SM_HEADER_SIZE + (off_t)pageNum * fileInfo->pageSize;
+}
+
+// Page sizes are whole multiples of PAGE_SIZE, which keeps every page aligned for O_DIRECT.
+static bool isValidPageSize(int pageSize)
+{
+    return pageSize >= PAGE_SIZE && pageSize <= SM_MAX_PAGE_SIZE && pageSize % PAGE_SIZE == 0;
+}
+
+// Rewrites the superblock with the current page count and free list.
+static bool writeSuperblock(SM_FileInfo *fileInfo, PageNumber pageCount)
+{
+    // aligned so the write also works on O_DIRECT descriptors
+    void *block = NULL;
+    if (posix_memalign(&block, SM_HEADER_SIZE, SM_HEADER_SIZE) != 0)
+    {
+        return false;
+    }
+    memset(block, 0, SM_HEADER_SIZE);
+
+    SM_FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SM_HEADER_MAGIC, sizeof(header.magic));
+    header.version = SM_HEADER_VERSION;
+    header.pageSize = fileInfo->pageSize;
+    header.pageCount = pageCount;
+    header.freeListHead = fileInfo->freeListHead;
+    header.freePageCount = fileInfo->freePageCount;
+    memcpy(block, &header, sizeof(header));
+
+    bool ok = pwriteFull(fileInfo->fd, block, SM_HEADER_SIZE, 0);
+    free(block);
+    return ok;
+}
+
+// Maps the first 'newSize' bytes of the file, dropping any previous mapping.
+static RC remapFile(SM_FileInfo *fileInfo, size_t newSize)
+{
+    if (fileInfo->map != NULL)
+    {
+        munmap(fileInfo->map, fileInfo->mapSize);
+        fileInfo->map = NULL;
+        fileInfo->mapSize = 0;
+    }
+    if (newSize == 0)
+    {
+        return RC_OK; // nothing to map yet
+    }
+
+    void *map = mmap(NULL, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, fileInfo->fd, 0);
+    if (map == MAP_FAILED)
+    {
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    fileInfo->map = (char *)map;
+    fileInfo->mapSize = newSize;
+    return RC_OK;
+}
+
+/* Grows the file to 'numPages' zero-filled pages without writing any of them.
+   Disk space is reserved a whole extent at a time with fallocate(FALLOC_FL_KEEP_SIZE),
+   which leaves the file size alone, so the size still gives the logical page count;
+   ftruncate then moves the logical end. A jump of several extents only reserves the
+   extent holding the new last page, the pages skipped over stay sparse until written.
+   Mapped files are remapped afterwards. */
+static RC extendFile(SM_FileHandle *fHandle, PageNumber numPages)
+{
+    SM_FileInfo *fileInfo = (SM_FileInfo *)fHandle->mgmtInfo;
+
+    if (numPages > fileInfo->allocatedPages)
+    {
+        PageNumber extent = fileInfo->extentPages;
+        PageNumber target = ((numPages + extent - 1) / extent) * extent;
+#ifdef FALLOC_FL_KEEP_SIZE
+        PageNumber first = target - extent > fileInfo->allocatedPages ? target - extent : fileInfo->allocatedPages;
+        off_t from = pageOffset(fileInfo, first);
+        off_t length = (off_t)(target - first) * fileInfo->pageSize;
+        // file systems without fallocate just get a sparse extension below
+        if (fallocate(fileInfo->fd, FALLOC_FL_KEEP_SIZE, from, length) != 0)
+        {
+            target = numPages;
+        }
+#else
+        target = numPages;
+#endif
+        fileInfo->allocatedPages = target;
+    }
+
+    // ftruncate extends the file with zero bytes, no page has to be written
+    if (ftruncate(fileInfo->fd, pageOffset(fileInfo, numPages)) != 0)
+    {
+        return RC_WRITE_FAILED;
+    }
+    if (fileInfo->mode == SM_MODE_MMAP && remapFile(fileInfo, pageOffset(fileInfo, numPages)) != RC_OK)
+    {
+        return RC_WRITE_FAILED;
+    }
+    if (!writeSuperblock(fileInfo, numPages))
+    {
+        return RC_WRITE_FAILED;
+    }
+    fHandle->totalNumPages = numPages;
+    return RC_OK;
+}
+
+// True when 'buf' satisfies the alignment O_DIRECT needs for a page transfer.
+static bool isPageAligned(const void *buf)
+{
+    return ((size_t)buf % PAGE_SIZE) == 0;
+}
+
+// Reads exactly 'size' bytes at 'offset', retrying on short reads and interrupts.
+static bool preadFull(int fd, char *buf, size_t size, off_t offset)
+{
+    while (size > 0)
+    {
+        ssize_t done = pread(fd, buf, size, offset);
+        if (done < 0 && errno == EINTR)
+            continue;
+        if (done <= 0)
+            return false;
+        buf += done;
+        size -= done;
+        offset += done;
+    }
+    return true;
+}
+
+// Writes exactly 'size' bytes at 'offset', retrying on short writes and interrupts.
+static bool pwriteFull(int fd, const char *buf, size_t size, off_t offset)
+{
+    while (size > 0)
+    {
+        ssize_t done = pwrite(fd, buf, size, offset);
+        if (done < 0 && errno == EINTR)
+            continue;
+        if (done <= 0)
+            return false;
+        buf += done;
+        size -= done;
+        offset += done;
+    }
+    return true;
+}
+
 // ------------------------------------  PAGE FILES MANIPULATION  ------------------------------------------------
 
 void initStorageManager(void)
@@ -12,67 +229,157 @@ void initStorageManager(void)
 //  Create a new file and adding a new page to it with zero bytes.
 RC createPageFile(char *fileName)
 {
+    return createPageFileWithPageSize(fileName, PAGE_SIZE);
+}
+
+//  Create a new file whose pages are 'pageSize' bytes: header block plus one zero page.
+RC createPageFileWithPageSize(char *fileName, int pageSize)
+{
+    if (fileName == NULL || !isValidPageSize(pageSize))
+    {
+        return RC_NULL_PARAM;
+    }
+
     /*      open the file for read and write based on fileName and if file is found then truncate it's contents,
         if not found create it. */
-    FILE *filePointer = fopen(fileName, "w+");
-    if (filePointer == NULL)
+    int fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
     {
         // return error if file creation or open file fails.
         return RC_FILE_NOT_FOUND;
     }
 
-    // Allocating memory for one page and setting it to '\0' (by default calloc intializes to zero).
-    char *emptyPage = (char *)calloc(PAGE_SIZE, sizeof(char));
-    // return error in case of emptyPage creation fails.
-    if (emptyPage == NULL)
+    // Allocating memory for the header and one page, set to '\0' (by default calloc intializes to zero).
+    char *block = (char *)calloc(SM_HEADER_SIZE + pageSize, sizeof(char));
+    // return error in case of block creation fails.
+    if (block == NULL)
     {
-        fclose(filePointer); // closing the file before leaving inorder to avoid memory leakage.
+        close(fd); // closing the file before leaving inorder to avoid memory leakage.
         return RC_WRITE_FAILED;
     }
 
-    // adding empty page created earlier (emptyPage) to the file.
-    size_t writeResult = fwrite(emptyPage, sizeof(char), PAGE_SIZE, filePointer);
-    if (writeResult < PAGE_SIZE)
+    SM_FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SM_HEADER_MAGIC, sizeof(header.magic));
+    header.version = SM_HEADER_VERSION;
+    header.pageSize = pageSize;
+    header.pageCount = 1;
+    header.freeListHead = -1;
+    header.freePageCount = 0;
+    memcpy(block, &header, sizeof(header));
+
+    // writing the header and the empty page created earlier to the file.
+    bool written = pwriteFull(fd, block, SM_HEADER_SIZE + pageSize, 0);
+
+    // Clean up and close the file.
+    free(block);
+    if (close(fd) != 0 || !written)
     {
-        free(emptyPage);     // Free allocated memory.
-        fclose(filePointer); // Close the file to prevent leakage.
         return RC_WRITE_FAILED;
     }
 
-    // Clean up and close the file.
-    free(emptyPage);
-    fclose(filePointer);
-
     return RC_OK;
 }
 
+/* Reads the superblock and returns the page count it records, or -1 if the file does not
+   start with a header of this version. */
+static PageNumber readFileHeader(int fd, SM_FileInfo *fileInfo)
+{
+    // aligned so the read also works on O_DIRECT descriptors
+    void *block = NULL;
+    if (posix_memalign(&block, SM_HEADER_SIZE, SM_HEADER_SIZE) != 0)
+    {
+        return -1;
+    }
+
+    PageNumber pageCount = -1;
+    // files shorter than a header block fail the read
+    if (preadFull(fd, block, SM_HEADER_SIZE, 0))
+    {
+        SM_FileHeader header;
+        memcpy(&header, block, sizeof(header));
+        if (memcmp(header.magic, SM_HEADER_MAGIC, sizeof(header.magic)) == 0 &&
+            header.version == SM_HEADER_VERSION && isValidPageSize(header.pageSize) && header.pageCount >= 0)
+        {
+            fileInfo->pageSize = header.pageSize;
+            fileInfo->freeListHead = header.freeListHead;
+            fileInfo->freePageCount = header.freePageCount;
+            pageCount = header.pageCount;
+        }
+    }
+    free(block);
+    return pageCount;
+}
+
 // Open the file page if the file is found and intialize the 'SM_FileHandle'.
 RC openPageFile(char *fileName, SM_FileHandle *fHandle)
+{
+    return openPageFileMode(fileName, fHandle, SM_MODE_PREAD);
+}
+
+// Open the file page with an explicit I/O mode (see SM_OpenMode).
+RC openPageFileMode(char *fileName, SM_FileHandle *fHandle, SM_OpenMode mode)
 {
     // Opening the file with read and write ability based on fileName if not found return ERROR.
-    FILE *filePointer = fopen(fileName, "r+");
-    if (filePointer == NULL)
+    int fd = -1;
+    if (mode == SM_MODE_DIRECT)
+    {
+#ifdef O_DIRECT
+        fd = open(fileName, O_RDWR | O_DIRECT);
+#endif
+        // File systems without direct I/O support (e.g. tmpfs) fall back to cached I/O
+        if (fd < 0 && errno != ENOENT)
+        {
+            mode = SM_MODE_PREAD;
+        }
+    }
+    if (fd < 0)
+    {
+        fd = open(fileName, O_RDWR);
+    }
+    if (fd < 0)
     {
         // return error if file not found
         return RC_FILE_NOT_FOUND;
     }
 
+    SM_FileInfo *fileInfo = (SM_FileInfo *)malloc(sizeof(SM_FileInfo));
+    if (fileInfo == NULL)
+    {
+        close(fd);
+        return RC_MEM_ALLOC_FAILURE;
+    }
+    fileInfo->fd = fd;
+    fileInfo->mode = mode;
+    fileInfo->map = NULL;
+    fileInfo->mapSize = 0;
+    // Total number of pages comes from the superblock
+    PageNumber numPages = readFileHeader(fd, fileInfo);
+    if (numPages < 0)
+    {
+        close(fd);
+        free(fileInfo);
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    fileInfo->allocatedPages = numPages;
+    fileInfo->extentPages = SM_DEFAULT_EXTENT_PAGES;
+
+    // Map every whole page of the file so blocks can be accessed in place
+    if (mode == SM_MODE_MMAP && remapFile(fileInfo, pageOffset(fileInfo, numPages)) != RC_OK)
+    {
+        close(fd);
+        free(fileInfo);
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+
     // Initialize the file handle structure.
     fHandle->fileName = fileName;
     fHandle->curPagePos = 0;
+    fHandle->pageSize = fileInfo->pageSize;
+    fHandle->totalNumPages = numPages;
 
-    // Finding total number of pages in the file.
-    /* Move filePointer to the end of the file using fseek() which basically has ability to traverse through the file.
-       SEEK_END specifies to move to the end of the file or last page. */
-    fseek(filePointer, 0, SEEK_END);
-    /* Get the file size as we already movef to the end of the file before using fseek(),
-     ftell() returns current page position in this case last page. */
-    long fileSize = ftell(filePointer);
-    // get the totalNumPages by fileSize / 4096;
-    fHandle->totalNumPages = fileSize / PAGE_SIZE;
-
-    // Store the FILE pointer in mgmtInfo
-    fHandle->mgmtInfo = filePointer;
+    // Store the descriptor in mgmtInfo
+    fHandle->mgmtInfo = fileInfo;
 
     return RC_OK;
 }
@@ -86,10 +393,11 @@ RC closePageFile(SM_FileHandle *fHandle)
         return RC_FILE_HANDLE_NOT_INIT;
     }
 
-    // creating a local instance of filePointer from SM_FileHandle structure.
-    FILE *filePointer = (FILE *)fHandle->mgmtInfo;
-    // Close the file
-    fclose(filePointer);
+    // Close the descriptor and release the handle state
+    SM_FileInfo *fileInfo = (SM_FileInfo *)fHandle->mgmtInfo;
+    remapFile(fileInfo, 0);
+    close(fileInfo->fd);
+    free(fileInfo);
 
     // making mgntInfo NULL to indicate that file is closed
     fHandle->mgmtInfo = NULL;
@@ -112,7 +420,113 @@ RC destroyPageFile(char *fileName)
 
 // -------------------------------------  READ BLOCKS FROM DISC  ------------------------------------------------
 
-RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
+/* Moves 'count' pages between the file and 'pages' with as few preadv/pwritev calls as
+   possible, resuming after short transfers. */
+static bool transferPages(SM_FileInfo *fileInfo, PageNumber startPage, int count, SM_PageHandle *pages, bool write)
+{
+#ifdef IOV_MAX
+    const int maxIov = IOV_MAX;
+#else
+    const int maxIov = 1024;
+#endif
+    struct iovec iov[count < maxIov ? count : maxIov];
+    int done = 0;
+
+    while (done < count)
+    {
+        int batch = count - done < maxIov ? count - done : maxIov;
+        for (int i = 0; i < batch; i++)
+        {
+            iov[i].iov_base = pages[done + i];
+            iov[i].iov_len = fileInfo->pageSize;
+        }
+
+        struct iovec *cur = iov;
+        int left = batch;
+        off_t offset = pageOffset(fileInfo, startPage + done);
+        while (left > 0)
+        {
+            ssize_t moved = write ? pwritev(fileInfo->fd, cur, left, offset)
+                                  : preadv(fileInfo->fd, cur, left, offset);
+            if (moved < 0 && errno == EINTR)
+                continue;
+            if (moved <= 0)
+                return false;
+            offset += moved;
+
+            // skip fully transferred pages, trim a partially transferred one
+            while (left > 0 && (size_t)moved >= cur->iov_len)
+            {
+                moved -= cur->iov_len;
+                cur++;
+                left--;
+            }
+            if (left > 0)
+            {
+                cur->iov_base = (char *)cur->iov_base + moved;
+                cur->iov_len -= moved;
+            }
+        }
+        done += batch;
+    }
+    return true;
+}
+
+/* SM_MODE_DIRECT needs page-aligned memory. Buffer pool frames already are, anything
+   else (e.g. a malloc'd page) is bounced through an aligned scratch page. */
+static bool readPage(SM_FileInfo *fileInfo, PageNumber pageNum, SM_PageHandle memPage)
+{
+    off_t offset = pageOffset(fileInfo, pageNum);
+    if (fileInfo->mode != SM_MODE_DIRECT || isPageAligned(memPage))
+    {
+        return preadFull(fileInfo->fd, memPage, fileInfo->pageSize, offset);
+    }
+
+    void *aligned = NULL;
+    if (posix_memalign(&aligned, PAGE_SIZE, fileInfo->pageSize) != 0)
+    {
+        return false;
+    }
+    bool ok = preadFull(fileInfo->fd, aligned, fileInfo->pageSize, offset);
+    if (ok)
+    {
+        memcpy(memPage, aligned, fileInfo->pageSize);
+    }
+    free(aligned);
+    return ok;
+}
+
+static bool writePage(SM_FileInfo *fileInfo, PageNumber pageNum, const char *memPage)
+{
+    off_t offset = pageOffset(fileInfo, pageNum);
+    if (fileInfo->mode != SM_MODE_DIRECT || isPageAligned(memPage))
+    {
+        return pwriteFull(fileInfo->fd, memPage, fileInfo->pageSize, offset);
+    }
+
+    void *aligned = NULL;
+    if (posix_memalign(&aligned, PAGE_SIZE, fileInfo->pageSize) != 0)
+    {
+        return false;
+    }
+    memcpy(aligned, memPage, fileInfo->pageSize);
+    bool ok = pwriteFull(fileInfo->fd, aligned, fileInfo->pageSize, offset);
+    free(aligned);
+    return ok;
+}
+
+RC readBlock(PageNumber pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
+{
+    RC rc = readBlockAt(pageNum, fHandle, memPage);
+    if (rc == RC_OK)
+    {
+        // Update  current page position
+        fHandle->curPagePos = pageNum;
+    }
+    return rc;
+}
+
+RC readBlockAt(PageNumber pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
     // Check if the page number is valid
     if (pageNum < 0 || pageNum >= fHandle->totalNumPages)
@@ -120,27 +534,87 @@ RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
         return RC_READ_NON_EXISTING_PAGE; // Return non existing page error
     }
 
-    // find correct page 
-    if (fseek(fHandle->mgmtInfo, pageNum * PAGE_SIZE, SEEK_SET) != 0)
+    int fd = fileDescriptor(fHandle);
+    if (fd < 0)
     {
-        return RC_FILE_HANDLE_NOT_INIT; // seek failed error
+        return RC_FILE_HANDLE_NOT_INIT;
     }
 
-    // Read  page into mem
-    size_t readResult = fread(memPage, sizeof(char), PAGE_SIZE, fHandle->mgmtInfo);
-    if (readResult < PAGE_SIZE)
+    // Copy out of the mapping when the file is memory mapped
+    SM_PageHandle mapped = getBlockPtr(pageNum, fHandle);
+    if (mapped != NULL)
+    {
+        memcpy(memPage, mapped, fHandle->pageSize);
+    }
+    // Read page into mem straight from its offset in the file
+    else if (!readPage((SM_FileInfo *)fHandle->mgmtInfo, pageNum, memPage))
     {
         return RC_FILE_HANDLE_NOT_INIT; // Return error  read fail 
-   }
-
-    // Update  current page position
-    fHandle->curPagePos = pageNum;
+    }
 
     return RC_OK; // Return success
 }
 
 
-int getBlockPos(SM_FileHandle *fHandle)
+RC readBlocks(PageNumber startPage, int count, SM_FileHandle *fHandle, SM_PageHandle *memPages)
+{
+    // Check that the whole run lies inside the file
+    if (count <= 0 || startPage < 0 || startPage + count > fHandle->totalNumPages || memPages == NULL)
+    {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    if (fileDescriptor(fHandle) < 0)
+    {
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+
+    SM_FileInfo *fileInfo = (SM_FileInfo *)fHandle->mgmtInfo;
+    bool vectored = fileInfo->map == NULL;
+    // direct I/O can only batch page-aligned buffers
+    for (int i = 0; vectored && fileInfo->mode == SM_MODE_DIRECT && i < count; i++)
+    {
+        vectored = isPageAligned(memPages[i]);
+    }
+    if (!vectored)
+    {
+        // mapped files and unaligned direct I/O go page by page
+        for (int i = 0; i < count; i++)
+        {
+            RC rc = readBlock(startPage + i, fHandle, memPages[i]);
+            if (rc != RC_OK)
+            {
+                return rc;
+            }
+        }
+        return RC_OK;
+    }
+
+    if (!transferPages(fileInfo, startPage, count, memPages, false))
+    {
+        return RC_FILE_HANDLE_NOT_INIT; // Return error  read fail
+    }
+
+    // Current page is the last one of the run
+    fHandle->curPagePos = startPage + count - 1;
+    return RC_OK;
+}
+
+SM_PageHandle getBlockPtr(PageNumber pageNum, SM_FileHandle *fHandle)
+{
+    // Only mapped files can hand out pointers into the file
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL)
+    {
+        return NULL;
+    }
+    SM_FileInfo *fileInfo = (SM_FileInfo *)fHandle->mgmtInfo;
+    if (fileInfo->map == NULL || pageNum < 0 || pageNum >= fHandle->totalNumPages)
+    {
+        return NULL;
+    }
+    return fileInfo->map + pageOffset(fileInfo, pageNum);
+}
+
+PageNumber getBlockPos(SM_FileHandle *fHandle)
 {
     // Return current page pos
     return fHandle->curPagePos;
@@ -155,7 +629,7 @@ RC readFirstBlock(SM_FileHandle *fHandle, SM_PageHandle memPage)
 RC readLastBlock(SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
     // Read last block 
-    int minusOne = fHandle->totalNumPages - 1;
+    PageNumber minusOne = fHandle->totalNumPages - 1;
     return readBlock(minusOne, fHandle, memPage);
 }
 
@@ -166,53 +640,99 @@ RC readPreviousBlock(SM_FileHandle *fHandle, SM_PageHandle memPage)
         return RC_READ_NON_EXISTING_PAGE; // no previous page
 
     // Read previous block, update curPagePos
-    int thePrevious = fHandle->curPagePos - 1;
+    PageNumber thePrevious = fHandle->curPagePos - 1;
     return readBlock(thePrevious, fHandle, memPage);
 }
 
 RC readCurrentBlock(SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
     // Read current block
-    int curBlock = fHandle->curPagePos;
+    PageNumber curBlock = fHandle->curPagePos;
     return readBlock(curBlock, fHandle, memPage);
 }
 
 RC readNextBlock(SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
     // Check next block
-    int checkNext = fHandle-> totalNumPages - 1;
+    PageNumber checkNext = fHandle-> totalNumPages - 1;
     if (fHandle->curPagePos >= checkNext)
         return RC_READ_NON_EXISTING_PAGE; // No next page 
 
     // Read the next block, update curPagePos
-    int readNext = fHandle->curPagePos+1;
+    PageNumber readNext = fHandle->curPagePos+1;
     return readBlock(readNext, fHandle, memPage);
 }
 
 
 // -------------------------------------  WRITE BLOCKS TO A PAGE FILE -------------------------------------------
 
-RC writeBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
+RC writeBlock(PageNumber pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
     // check if the pageNumber is legit
     if (pageNum < 0 || pageNum >= fHandle->totalNumPages)
     {
         return RC_WRITE_FAILED; // return back error as page cannot be written
     }
-    // seek to correct page based on page number
-    if (fseek(fHandle->mgmtInfo, pageNum * PAGE_SIZE, SEEK_SET != 0))
+    int fd = fileDescriptor(fHandle);
+    if (fd < 0)
     {
-        return RC_WRITE_FAILED; // return error as page cannot be written
+        return RC_WRITE_FAILED;
     }
-    // Write the page from memory (memPage) to the file
-    size_t writeResult = fwrite(memPage, sizeof(char), PAGE_SIZE, fHandle->mgmtInfo);
-    if (writeResult < PAGE_SIZE)
+    // Copy into the mapping when the file is memory mapped
+    SM_PageHandle mapped = getBlockPtr(pageNum, fHandle);
+    if (mapped != NULL)
+    {
+        // the caller may already be writing through getBlockPtr
+        if (mapped != memPage)
+        {
+            memcpy(mapped, memPage, fHandle->pageSize);
+        }
+        return RC_OK;
+    }
+    // Write the page from memory (memPage) to its offset in the file
+    if (!writePage((SM_FileInfo *)fHandle->mgmtInfo, pageNum, memPage))
     {
         return RC_WRITE_FAILED; // Return error if writing fails
     }
     return RC_OK;
 }
 
+RC writeBlocks(PageNumber startPage, int count, SM_FileHandle *fHandle, SM_PageHandle *memPages)
+{
+    // check that the whole run lies inside the file
+    if (count <= 0 || startPage < 0 || startPage + count > fHandle->totalNumPages || memPages == NULL)
+    {
+        return RC_WRITE_FAILED;
+    }
+    if (fileDescriptor(fHandle) < 0)
+    {
+        return RC_WRITE_FAILED;
+    }
+
+    SM_FileInfo *fileInfo = (SM_FileInfo *)fHandle->mgmtInfo;
+    bool vectored = fileInfo->map == NULL;
+    // direct I/O can only batch page-aligned buffers
+    for (int i = 0; vectored && fileInfo->mode == SM_MODE_DIRECT && i < count; i++)
+    {
+        vectored = isPageAligned(memPages[i]);
+    }
+    if (vectored)
+    {
+        return transferPages(fileInfo, startPage, count, memPages, true) ? RC_OK : RC_WRITE_FAILED;
+    }
+
+    // mapped files and unaligned direct I/O go page by page
+    for (int i = 0; i < count; i++)
+    {
+        RC rc = writeBlock(startPage + i, fHandle, memPages[i]);
+        if (rc != RC_OK)
+        {
+            return rc;
+        }
+    }
+    return RC_OK;
+}
+
 RC writeCurrentBlock(SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
     // Check if the currentPagePosition is legit
@@ -221,76 +741,714 @@ RC writeCurrentBlock(SM_FileHandle *fHandle, SM_PageHandle memPage)
         return RC_WRITE_FAILED; // Return error if current page is invalid
     }
 
-    // Seek to the current block position based on CurrentPagePosition
-    if (fseek(fHandle->mgmtInfo, fHandle->curPagePos * PAGE_SIZE, SEEK_SET) != 0)
+    // Write the memory page(memPage) to the current position
+    return writeBlock(fHandle->curPagePos, fHandle, memPage);
+}
+
+RC appendEmptyBlock(SM_FileHandle *fHandle)
+{
+    if (fileDescriptor(fHandle) < 0)
     {
-        return RC_WRITE_FAILED; // Return error if seek fails
+        return RC_WRITE_FAILED;
     }
 
-    // Write the memory page(memPage) to the current position
-    size_t writeResult = fwrite(memPage, sizeof(char), PAGE_SIZE, fHandle->mgmtInfo);
-    if (writeResult < PAGE_SIZE)
+    // Add one zero page after the last page and update the total number of pages
+    return extendFile(fHandle, fHandle->totalNumPages + 1);
+}
+
+RC ensureCapacity(PageNumber numberOfPages, SM_FileHandle *fHandle)
+{
+    // Check if the file already has the maximum numberOfPages
+    if (fHandle->totalNumPages >= numberOfPages)
     {
-        return RC_WRITE_FAILED; // Return error if writing fails
+        return RC_OK; // Ok as no need of adding more pages
     }
 
-    return RC_OK; // Return success
+    if (fileDescriptor(fHandle) < 0)
+    {
+        return RC_WRITE_FAILED;
+    }
+
+    // Grow to numberOfPages in one step instead of appending page by page
+    return extendFile(fHandle, numberOfPages);
 }
 
-RC appendEmptyBlock(SM_FileHandle *fHandle)
+RC setExtentSize(int pagesPerExtent, SM_FileHandle *fHandle)
 {
-    // Create an empty page with '/0' bytes
-    SM_PageHandle emptyPage = (SM_PageHandle)calloc(PAGE_SIZE, sizeof(char));
+    if (pagesPerExtent <= 0)
+    {
+        return RC_NULL_PARAM;
+    }
+    if (fileDescriptor(fHandle) < 0)
+    {
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+
+    ((SM_FileInfo *)fHandle->mgmtInfo)->extentPages = pagesPerExtent;
+    return RC_OK;
+}
+
+// -------------------------------------  PAGE ALLOCATION  -----------------------------------------------------
+
+RC allocatePage(SM_FileHandle *fHandle, PageNumber *pageNum)
+{
+    if (pageNum == NULL)
+    {
+        return RC_NULL_PARAM;
+    }
+    if (fileDescriptor(fHandle) < 0)
+    {
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+
+    SM_FileInfo *fileInfo = (SM_FileInfo *)fHandle->mgmtInfo;
+    // Nothing to reuse: grow the file by one page
+    if (fileInfo->freeListHead < 0)
+    {
+        RC rc = extendFile(fHandle, fHandle->totalNumPages + 1);
+        if (rc == RC_OK)
+        {
+            *pageNum = fHandle->totalNumPages - 1;
+        }
+        return rc;
+    }
 
-    if (emptyPage == NULL)
+    void *page = NULL;
+    if (posix_memalign(&page, PAGE_SIZE, fileInfo->pageSize) != 0)
+    {
+        return RC_MEM_ALLOC_FAILURE;
+    }
+
+    /* Pop the head of the free list; the page's first PageNumber links to the next free
+       page. The count, not the link, ends the list. */
+    PageNumber reused = fileInfo->freeListHead;
+    if (!readPage(fileInfo, reused, page))
+    {
+        free(page);
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    PageNumber next = -1;
+    if (fileInfo->freePageCount > 1)
     {
-        return RC_WRITE_FAILED; // Return error if page cannot be written due to memory allocation failure
+        memcpy(&next, page, sizeof(PageNumber));
     }
 
-    // Move to the end of the file
-    if (fseek(fHandle->mgmtInfo, 0, SEEK_END) != 0)
+    // Hand the page out zeroed, like a freshly appended one
+    memset(page, 0, fileInfo->pageSize);
+    bool ok = writePage(fileInfo, reused, page);
+    free(page);
+    if (!ok)
     {
-        free(emptyPage); // Free or erase the memory before returning
         return RC_WRITE_FAILED;
     }
 
-    // Writing the empty block (all zeros) to the file
-    size_t writeResult = fwrite(emptyPage, sizeof(char), PAGE_SIZE, fHandle->mgmtInfo);
-    if (writeResult < PAGE_SIZE)
+    fileInfo->freeListHead = next;
+    fileInfo->freePageCount--;
+    if (!writeSuperblock(fileInfo, fHandle->totalNumPages))
     {
-        free(emptyPage);        // Free the memory before returning
-        return RC_WRITE_FAILED; // Return error if writing fails
+        return RC_WRITE_FAILED;
+    }
+    *pageNum = reused;
+    return RC_OK;
+}
+
+/* Walks the free list for pageNum, reading each link into 'page'; false as well when a
+   link cannot be read, which *ok reports. */
+static bool isFreePage(SM_FileInfo *fileInfo, PageNumber pageNum, char *page, bool *ok)
+{
+    PageNumber cur = fileInfo->freeListHead;
+    *ok = true;
+    for (PageNumber i = 0; i < fileInfo->freePageCount; i++)
+    {
+        if (cur == pageNum)
+        {
+            return true;
+        }
+        if (i + 1 < fileInfo->freePageCount)
+        {
+            if (!readPage(fileInfo, cur, page))
+            {
+                *ok = false;
+                return false;
+            }
+            memcpy(&cur, page, sizeof(PageNumber));
+        }
+    }
+    return false;
+}
+
+RC freePage(PageNumber pageNum, SM_FileHandle *fHandle)
+{
+    if (fileDescriptor(fHandle) < 0)
+    {
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    if (pageNum < 0 || pageNum >= fHandle->totalNumPages)
+    {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    SM_FileInfo *fileInfo = (SM_FileInfo *)fHandle->mgmtInfo;
+
+    void *page = NULL;
+    if (posix_memalign(&page, PAGE_SIZE, fileInfo->pageSize) != 0)
+    {
+        return RC_MEM_ALLOC_FAILURE;
+    }
+
+    // A page freed twice would link to itself and be handed out twice
+    bool readOk;
+    if (isFreePage(fileInfo, pageNum, page, &readOk) || !readOk)
+    {
+        free(page);
+        return readOk ? RC_PAGE_ALREADY_FREE : RC_READ_FAILED;
+    }
+
+    // Push the page on the free list: link it to the current head
+    memset(page, 0, fileInfo->pageSize);
+    memcpy(page, &fileInfo->freeListHead, sizeof(PageNumber));
+    bool ok = writePage(fileInfo, pageNum, page);
+    free(page);
+    if (!ok)
+    {
+        return RC_WRITE_FAILED;
+    }
+
+    fileInfo->freeListHead = pageNum;
+    fileInfo->freePageCount++;
+    return writeSuperblock(fileInfo, fHandle->totalNumPages) ? RC_OK : RC_WRITE_FAILED;
+}
+
+PageNumber getNumFreePages(SM_FileHandle *fHandle)
+{
+    if (fileDescriptor(fHandle) < 0)
+    {
+        return -1;
+    }
+    return ((SM_FileInfo *)fHandle->mgmtInfo)->freePageCount;
+}
+
+// -------------------------------------  ASYNCHRONOUS BLOCK I/O  -----------------------------------------------
+
+/* Requests live in a fixed array of slots (queueDepth of them). On Linux the slots are
+   handed to io_uring; when the kernel refuses io_uring (old kernel, seccomp, ...) a small
+   pool of worker threads runs the same requests with pread/pwrite. */
+
+#define SM_ASYNC_WORKERS 4
+
+typedef struct SM_AsyncSlot
+{
+    bool inUse;
+    bool write;
+    PageNumber pageNum;
+    SM_PageHandle memPage;
+    SM_FileInfo *fileInfo;
+    void *tag;
+    RC status;
+    SM_PageHandle bounce; // aligned copy of an unaligned memPage of an SM_MODE_DIRECT file
+    struct iovec iov;
+} SM_AsyncSlot;
+
+#ifdef __linux__
+// io_uring rings mapped from the kernel
+typedef struct SM_Uring
+{
+    int ringFd;
+    void *sqRing;
+    size_t sqRingSize;
+    void *cqRing;
+    size_t cqRingSize;
+    struct io_uring_sqe *sqes;
+    size_t sqesSize;
+    unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+    unsigned *cqHead, *cqTail, *cqMask;
+    struct io_uring_cqe *cqes;
+    unsigned toSubmit; // queued in the SQ ring but not yet passed to io_uring_enter
+} SM_Uring;
+#endif
+
+struct SM_AsyncIO
+{
+    int queueDepth;
+    int inFlight;
+    SM_AsyncSlot *slots;
+    bool useUring;
+#ifdef __linux__
+    SM_Uring uring;
+#endif
+
+    // thread pool fallback: FIFO rings of slot indices guarded by one mutex
+    pthread_t workers[SM_ASYNC_WORKERS];
+    pthread_mutex_t lock;
+    pthread_cond_t workAvailable;
+    pthread_cond_t workDone;
+    int *pending;
+    int pendingHead, pendingCount;
+    int *done;
+    int doneHead, doneCount;
+    bool stopping;
+};
+
+#ifdef __linux__
+static int uringSetup(unsigned entries, struct io_uring_params *params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, NULL, 0);
+}
+
+static void uringTeardown(SM_Uring *ring)
+{
+    if (ring->sqes != NULL)
+        munmap(ring->sqes, ring->sqesSize);
+    if (ring->cqRing != NULL && ring->cqRing != ring->sqRing)
+        munmap(ring->cqRing, ring->cqRingSize);
+    if (ring->sqRing != NULL)
+        munmap(ring->sqRing, ring->sqRingSize);
+    if (ring->ringFd >= 0)
+        close(ring->ringFd);
+    memset(ring, 0, sizeof(SM_Uring));
+    ring->ringFd = -1;
+}
+
+// Creates the rings; returns false if io_uring is not usable on this system.
+static bool uringInit(SM_Uring *ring, unsigned entries)
+{
+    struct io_uring_params params;
+    memset(ring, 0, sizeof(SM_Uring));
+    memset(&params, 0, sizeof(params));
+
+    ring->ringFd = uringSetup(entries, &params);
+    if (ring->ringFd < 0)
+    {
+        return false;
+    }
+
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (ring->cqRingSize > ring->sqRingSize)
+            ring->sqRingSize = ring->cqRingSize;
+        ring->cqRingSize = ring->sqRingSize;
+    }
+
+    void *sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring->ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED)
+    {
+        uringTeardown(ring);
+        return false;
+    }
+    ring->sqRing = sqRing;
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        ring->cqRing = sqRing;
+    }
+    else
+    {
+        void *cqRing = mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring->ringFd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED)
+        {
+            uringTeardown(ring);
+            return false;
+        }
+        ring->cqRing = cqRing;
+    }
+
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->ringFd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        uringTeardown(ring);
+        return false;
+    }
+    ring->sqes = (struct io_uring_sqe *)sqes;
+
+    char *sq = (char *)ring->sqRing;
+    ring->sqHead = (unsigned *)(sq + params.sq_off.head);
+    ring->sqTail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sqMask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sqArray = (unsigned *)(sq + params.sq_off.array);
+
+    char *cq = (char *)ring->cqRing;
+    ring->cqHead = (unsigned *)(cq + params.cq_off.head);
+    ring->cqTail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cqMask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return true;
+}
+
+// Queues one readv/writev in the submission ring, keyed by its slot index.
+static void uringQueue(SM_Uring *ring, SM_AsyncSlot *slot, int slotIndex)
+{
+    unsigned tail = *ring->sqTail;
+    unsigned index = tail & *ring->sqMask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = slot->write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = slot->fileInfo->fd;
+    sqe->off = (unsigned long long)pageOffset(slot->fileInfo, slot->pageNum);
+    sqe->addr = (unsigned long long)(size_t)&slot->iov;
+    sqe->len = 1;
+    sqe->user_data = (unsigned long long)slotIndex;
+
+    ring->sqArray[index] = index;
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+    ring->toSubmit++;
+}
+
+// Passes queued requests to the kernel, optionally waiting for one completion.
+static RC uringSubmit(SM_Uring *ring, bool waitForOne)
+{
+    unsigned flags = waitForOne ? IORING_ENTER_GETEVENTS : 0;
+    while (ring->toSubmit > 0 || waitForOne)
+    {
+        int submitted = uringEnter(ring->ringFd, ring->toSubmit, waitForOne ? 1 : 0, flags);
+        if (submitted < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return RC_ERROR;
+        }
+        ring->toSubmit -= submitted;
+        if (waitForOne)
+            break;
+    }
+    return RC_OK;
+}
+#endif
+
+// Worker thread of the fallback pool: runs pending requests until shutdown.
+static void *asyncWorker(void *arg)
+{
+    SM_AsyncIO *aio = (SM_AsyncIO *)arg;
+
+    pthread_mutex_lock(&aio->lock);
+    while (true)
+    {
+        while (aio->pendingCount == 0 && !aio->stopping)
+        {
+            pthread_cond_wait(&aio->workAvailable, &aio->lock);
+        }
+        if (aio->pendingCount == 0 && aio->stopping)
+        {
+            break;
+        }
+
+        int slotIndex = aio->pending[aio->pendingHead];
+        aio->pendingHead = (aio->pendingHead + 1) % aio->queueDepth;
+        aio->pendingCount--;
+        pthread_mutex_unlock(&aio->lock);
+
+        SM_AsyncSlot *slot = &aio->slots[slotIndex];
+        bool ok = slot->write ? writePage(slot->fileInfo, slot->pageNum, slot->iov.iov_base)
+                              : readPage(slot->fileInfo, slot->pageNum, slot->iov.iov_base);
+        slot->status = ok ? RC_OK : (slot->write ? RC_WRITE_FAILED : RC_READ_FAILED);
+
+        pthread_mutex_lock(&aio->lock);
+        aio->done[(aio->doneHead + aio->doneCount) % aio->queueDepth] = slotIndex;
+        aio->doneCount++;
+        pthread_cond_signal(&aio->workDone);
+    }
+    pthread_mutex_unlock(&aio->lock);
+    return NULL;
+}
+
+RC initAsyncIO(SM_AsyncIO **aio, int queueDepth)
+{
+    if (aio == NULL || queueDepth <= 0)
+    {
+        return RC_NULL_PARAM;
     }
 
-    // Free or erase the allocated empty page after writing
-    free(emptyPage);
+    SM_AsyncIO *engine = (SM_AsyncIO *)calloc(1, sizeof(SM_AsyncIO));
+    if (engine == NULL)
+    {
+        return RC_MEM_ALLOC_FAILURE;
+    }
+    engine->queueDepth = queueDepth;
+    engine->slots = (SM_AsyncSlot *)calloc(queueDepth, sizeof(SM_AsyncSlot));
+    engine->pending = (int *)malloc(queueDepth * sizeof(int));
+    engine->done = (int *)malloc(queueDepth * sizeof(int));
+    if (engine->slots == NULL || engine->pending == NULL || engine->done == NULL)
+    {
+        free(engine->slots);
+        free(engine->pending);
+        free(engine->done);
+        free(engine);
+        return RC_MEM_ALLOC_FAILURE;
+    }
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->workAvailable, NULL);
+    pthread_cond_init(&engine->workDone, NULL);
 
-    // Updating file's metadata: increment the total number of pages
-    fHandle->totalNumPages += 1;
+#ifdef __linux__
+    engine->useUring = uringInit(&engine->uring, queueDepth);
+#endif
+    if (!engine->useUring)
+    {
+        for (int i = 0; i < SM_ASYNC_WORKERS; i++)
+        {
+            if (pthread_create(&engine->workers[i], NULL, asyncWorker, engine) != 0)
+            {
+                // stop the workers already started
+                pthread_mutex_lock(&engine->lock);
+                engine->stopping = true;
+                pthread_cond_broadcast(&engine->workAvailable);
+                pthread_mutex_unlock(&engine->lock);
+                for (int j = 0; j < i; j++)
+                    pthread_join(engine->workers[j], NULL);
+                pthread_mutex_destroy(&engine->lock);
+                pthread_cond_destroy(&engine->workAvailable);
+                pthread_cond_destroy(&engine->workDone);
+                free(engine->slots);
+                free(engine->pending);
+                free(engine->done);
+                free(engine);
+                return RC_ERROR;
+            }
+        }
+    }
 
+    *aio = engine;
     return RC_OK;
 }
 
-RC ensureCapacity(int numberOfPages, SM_FileHandle *fHandle)
+RC shutdownAsyncIO(SM_AsyncIO *aio)
 {
-    // Check if the file already has the maximum numberOfPages
-    if (fHandle->totalNumPages >= numberOfPages)
+    if (aio == NULL)
     {
-        return RC_OK; // Ok as no need of adding more pages
+        return RC_NULL_PARAM;
+    }
+
+    // Let outstanding requests finish so no buffer is written after we return
+    SM_IOCompletion completion;
+    while (aio->inFlight > 0)
+    {
+        if (waitAsyncIO(aio, &completion, 1) < 0)
+            break;
+    }
+
+#ifdef __linux__
+    if (aio->useUring)
+    {
+        uringTeardown(&aio->uring);
     }
+#endif
+    if (!aio->useUring)
+    {
+        pthread_mutex_lock(&aio->lock);
+        aio->stopping = true;
+        pthread_cond_broadcast(&aio->workAvailable);
+        pthread_mutex_unlock(&aio->lock);
+        for (int i = 0; i < SM_ASYNC_WORKERS; i++)
+            pthread_join(aio->workers[i], NULL);
+    }
+
+    pthread_mutex_destroy(&aio->lock);
+    pthread_cond_destroy(&aio->workAvailable);
+    pthread_cond_destroy(&aio->workDone);
+    free(aio->slots);
+    free(aio->pending);
+    free(aio->done);
+    free(aio);
+    return RC_OK;
+}
 
-    // Calculate number of additional pages can be taken
-    int additionalPages = numberOfPages - fHandle->totalNumPages;
+bool asyncIOUsesUring(SM_AsyncIO *aio)
+{
+    return aio != NULL && aio->useUring;
+}
+
+// Common path of submitReadBlock/submitWriteBlock.
+static RC submitBlock(SM_AsyncIO *aio, bool write, PageNumber pageNum, SM_FileHandle *fHandle,
+                      SM_PageHandle memPage, void *tag)
+{
+    if (aio == NULL || memPage == NULL)
+    {
+        return RC_NULL_PARAM;
+    }
+    if (pageNum < 0 || pageNum >= fHandle->totalNumPages)
+    {
+        return write ? RC_WRITE_FAILED : RC_READ_NON_EXISTING_PAGE;
+    }
+    if (fileDescriptor(fHandle) < 0)
+    {
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    if (aio->inFlight >= aio->queueDepth)
+    {
+        return RC_ASYNC_QUEUE_FULL;
+    }
 
-    // Append empty blocks to reach the value of additionalPages
-    for (int i = 0; i < additionalPages; i++)
+    // io_uring hands the buffer straight to the kernel, so O_DIRECT needs it aligned
+    SM_FileInfo *fileInfo = (SM_FileInfo *)fHandle->mgmtInfo;
+    SM_PageHandle bounce = NULL;
+    if (fileInfo->mode == SM_MODE_DIRECT && !isPageAligned(memPage))
     {
-        RC result = appendEmptyBlock(fHandle);
-        if (result != RC_OK)
+        if (posix_memalign((void **)&bounce, PAGE_SIZE, fHandle->pageSize) != 0)
+        {
+            return RC_MEM_ALLOC_FAILURE;
+        }
+        if (write)
         {
-            return result; // Return error if appending a block fails
+            memcpy(bounce, memPage, fHandle->pageSize);
         }
     }
 
+    // Grab a free slot
+    int slotIndex = 0;
+    while (aio->slots[slotIndex].inUse)
+    {
+        slotIndex++;
+    }
+    SM_AsyncSlot *slot = &aio->slots[slotIndex];
+    slot->inUse = true;
+    slot->write = write;
+    slot->pageNum = pageNum;
+    slot->memPage = memPage;
+    slot->fileInfo = fileInfo;
+    slot->tag = tag;
+    slot->status = RC_OK;
+    slot->bounce = bounce;
+    slot->iov.iov_base = bounce != NULL ? bounce : memPage;
+    slot->iov.iov_len = fHandle->pageSize;
+    aio->inFlight++;
+
+#ifdef __linux__
+    if (aio->useUring)
+    {
+        uringQueue(&aio->uring, slot, slotIndex);
+        return RC_OK;
+    }
+#endif
+
+    pthread_mutex_lock(&aio->lock);
+    aio->pending[(aio->pendingHead + aio->pendingCount) % aio->queueDepth] = slotIndex;
+    aio->pendingCount++;
+    pthread_cond_signal(&aio->workAvailable);
+    pthread_mutex_unlock(&aio->lock);
     return RC_OK;
 }
+
+RC submitReadBlock(SM_AsyncIO *aio, PageNumber pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage, void *tag)
+{
+    return submitBlock(aio, false, pageNum, fHandle, memPage, tag);
+}
+
+RC submitWriteBlock(SM_AsyncIO *aio, PageNumber pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage, void *tag)
+{
+    return submitBlock(aio, true, pageNum, fHandle, memPage, tag);
+}
+
+RC startAsyncIO(SM_AsyncIO *aio)
+{
+    if (aio == NULL)
+    {
+        return RC_NULL_PARAM;
+    }
+#ifdef __linux__
+    if (aio->useUring)
+    {
+        return uringSubmit(&aio->uring, false);
+    }
+#endif
+    return RC_OK; // worker threads pick requests up as soon as they are queued
+}
+
+// Copies a finished slot into 'completion' and frees it, a page read into its bounce page
+// copied out first.
+static void completeSlot(SM_AsyncIO *aio, int slotIndex, SM_IOCompletion *completion)
+{
+    SM_AsyncSlot *slot = &aio->slots[slotIndex];
+    if (slot->bounce != NULL)
+    {
+        if (!slot->write && slot->status == RC_OK)
+        {
+            memcpy(slot->memPage, slot->bounce, slot->fileInfo->pageSize);
+        }
+        free(slot->bounce);
+        slot->bounce = NULL;
+    }
+    completion->pageNum = slot->pageNum;
+    completion->memPage = slot->memPage;
+    completion->tag = slot->tag;
+    completion->status = slot->status;
+    slot->inUse = false;
+    aio->inFlight--;
+}
+
+// Collects up to 'max' finished requests; with 'wait' blocks until at least one is done.
+static int reapAsyncIO(SM_AsyncIO *aio, SM_IOCompletion *completions, int max, bool wait)
+{
+    if (aio == NULL || completions == NULL || max <= 0)
+    {
+        return -1;
+    }
+    if (aio->inFlight == 0)
+    {
+        return 0;
+    }
+
+    int found = 0;
+#ifdef __linux__
+    if (aio->useUring)
+    {
+        SM_Uring *ring = &aio->uring;
+        unsigned head = *ring->cqHead;
+        if (head == __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE) || ring->toSubmit > 0)
+        {
+            if (uringSubmit(ring, wait && head == __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE)) != RC_OK)
+                return -1;
+        }
+
+        unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail && found < max)
+        {
+            struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cqMask];
+            SM_AsyncSlot *slot = &aio->slots[cqe->user_data];
+            if (cqe->res != slot->fileInfo->pageSize)
+            {
+                slot->status = slot->write ? RC_WRITE_FAILED : RC_READ_FAILED;
+            }
+            completeSlot(aio, (int)cqe->user_data, &completions[found++]);
+            head++;
+        }
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+        return found;
+    }
+#endif
+
+    pthread_mutex_lock(&aio->lock);
+    while (wait && aio->doneCount == 0)
+    {
+        pthread_cond_wait(&aio->workDone, &aio->lock);
+    }
+    while (aio->doneCount > 0 && found < max)
+    {
+        int slotIndex = aio->done[aio->doneHead];
+        aio->doneHead = (aio->doneHead + 1) % aio->queueDepth;
+        aio->doneCount--;
+        completeSlot(aio, slotIndex, &completions[found++]);
+    }
+    pthread_mutex_unlock(&aio->lock);
+    return found;
+}
+
+int pollAsyncIO(SM_AsyncIO *aio, SM_IOCompletion *completions, int max)
+{
+    return reapAsyncIO(aio, completions, max, false);
+}
+
+int waitAsyncIO(SM_AsyncIO *aio, SM_IOCompletion *completions, int max)
+{
+    return reapAsyncIO(aio, completions, max, true);
+}
@@ -2,42 +2,107 @@
 #define STORAGE_MGR_H
 
 #include "dberror.h"
+#include "dt.h"
 
 /************************************************************
  *                    handle data structures                *
  ************************************************************/
 typedef struct SM_FileHandle {
 	char *fileName;
-	int totalNumPages;
-	int curPagePos;
+	PageNumber totalNumPages;
+	PageNumber curPagePos;
+	int pageSize;	// bytes per page, recorded in the file header at creation
 	void *mgmtInfo;
 } SM_FileHandle;
 
 typedef char* SM_PageHandle;
 
+/* largest page size a file can be created with; page sizes are multiples of PAGE_SIZE */
+#define SM_MAX_PAGE_SIZE 65536
+
+/* disk space is reserved in extents of this many pages when a file grows */
+#define SM_DEFAULT_EXTENT_PAGES 16
+
+/* I/O modes for openPageFileMode */
+typedef enum SM_OpenMode {
+	SM_MODE_PREAD = 0,	// pread/pwrite on a descriptor (default of openPageFile)
+	SM_MODE_MMAP = 1,	// whole file mapped, blocks reachable in place via getBlockPtr
+	SM_MODE_DIRECT = 2	// O_DIRECT, bypasses the OS page cache; page-aligned memory avoids a bounce copy
+} SM_OpenMode;
+
 /************************************************************
  *                    interface                             *
  ************************************************************/
 /* manipulating page files */
 extern void initStorageManager (void);
 extern RC createPageFile (char *fileName);
+extern RC createPageFileWithPageSize (char *fileName, int pageSize);
 extern RC openPageFile (char *fileName, SM_FileHandle *fHandle);
+extern RC openPageFileMode (char *fileName, SM_FileHandle *fHandle, SM_OpenMode mode);
 extern RC closePageFile (SM_FileHandle *fHandle);
 extern RC destroyPageFile (char *fileName);
 
 /* reading blocks from disc */
-extern RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
-extern int getBlockPos (SM_FileHandle *fHandle);
+extern RC readBlock (PageNumber pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+/* readBlock without moving the current page position, so threads can share a handle */
+extern RC readBlockAt (PageNumber pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern PageNumber getBlockPos (SM_FileHandle *fHandle);
+/* pointer into the mapping of an SM_MODE_MMAP file, NULL otherwise;
+   only valid until the file grows (appendEmptyBlock/ensureCapacity remap it) */
+extern SM_PageHandle getBlockPtr (PageNumber pageNum, SM_FileHandle *fHandle);
 extern RC readFirstBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+/* read 'count' consecutive pages starting at startPage into memPages[0..count-1] */
+extern RC readBlocks (PageNumber startPage, int count, SM_FileHandle *fHandle, SM_PageHandle *memPages);
 
 /* writing blocks to a page file */
-extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC writeBlock (PageNumber pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+/* write memPages[0..count-1] to 'count' consecutive pages starting at startPage */
+extern RC writeBlocks (PageNumber startPage, int count, SM_FileHandle *fHandle, SM_PageHandle *memPages);
 extern RC appendEmptyBlock (SM_FileHandle *fHandle);
-extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
+extern RC ensureCapacity (PageNumber numberOfPages, SM_FileHandle *fHandle);
+/* change how many pages are reserved at once when this handle grows its file */
+extern RC setExtentSize (int pagesPerExtent, SM_FileHandle *fHandle);
+
+/* page allocation: allocatePage reuses a freed page (returned zeroed) before growing
+   the file, freePage puts a page on the file's free list (RC_PAGE_ALREADY_FREE if it is
+   on it already); the list lives in the superblock, so only one handle per file should
+   allocate and free at a time */
+extern RC allocatePage (SM_FileHandle *fHandle, PageNumber *pageNum);
+extern RC freePage (PageNumber pageNum, SM_FileHandle *fHandle);
+extern PageNumber getNumFreePages (SM_FileHandle *fHandle);
+
+/************************************************************
+ *                    asynchronous I/O                      *
+ ************************************************************/
+/* Requests are queued with submitReadBlock/submitWriteBlock, handed to the
+   kernel by startAsyncIO (or implicitly by poll/wait) and collected with
+   pollAsyncIO/waitAsyncIO. Uses io_uring when available, otherwise a small
+   pool of worker threads. One engine must only be driven by one thread, the
+   memory of a request must stay valid until its completion is collected and
+   the SM_FileHandle must stay open until then. */
+typedef struct SM_AsyncIO SM_AsyncIO;
+
+typedef struct SM_IOCompletion {
+	PageNumber pageNum;
+	SM_PageHandle memPage;
+	void *tag;	// as passed to submitReadBlock/submitWriteBlock
+	RC status;	// RC_OK, RC_READ_FAILED or RC_WRITE_FAILED
+} SM_IOCompletion;
+
+extern RC initAsyncIO (SM_AsyncIO **aio, int queueDepth);
+extern RC shutdownAsyncIO (SM_AsyncIO *aio);
+extern bool asyncIOUsesUring (SM_AsyncIO *aio);
+extern RC submitReadBlock (SM_AsyncIO *aio, PageNumber pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage, void *tag);
+extern RC submitWriteBlock (SM_AsyncIO *aio, PageNumber pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage, void *tag);
+extern RC startAsyncIO (SM_AsyncIO *aio);
+/* both return the number of completions stored (at most max) or -1 on error;
+   waitAsyncIO blocks until at least one request finished, unless none is in flight */
+extern int pollAsyncIO (SM_AsyncIO *aio, SM_IOCompletion *completions, int max);
+extern int waitAsyncIO (SM_AsyncIO *aio, SM_IOCompletion *completions, int max);
 
 #endif
@@ -0,0 +1,181 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "dberror.h"
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "test_helper.h"
+
+/* test output files */
+#define TESTPF "test_large.bin"
+
+/* first page that starts past the 4 GB boundary (page 0 follows the header block) */
+#define PAST_4GB_PAGE ((4LL << 30) / PAGE_SIZE + 1)
+
+// test methods
+static void testStoragePast4GB (void);
+static void testBufferPoolPast4GB (void);
+static void testFreeListPast4GB (void);
+
+// helper methods
+static void fillPage (SM_PageHandle page, PageNumber pageNum);
+static bool checkPage (SM_PageHandle page, PageNumber pageNum);
+
+// test name
+char *testName;
+
+// main method
+int
+main (void)
+{
+  testName = "";
+
+  initStorageManager();
+
+  testStoragePast4GB();
+  testBufferPoolPast4GB();
+  testFreeListPast4GB();
+
+  return 0;
+}
+
+// ************************************************************
+void
+testStoragePast4GB (void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle ph = (SM_PageHandle) malloc(PAGE_SIZE);
+  struct stat st;
+
+  testName = "test reading and writing pages past 4 GB";
+
+  TEST_CHECK(createPageFile(TESTPF));
+  TEST_CHECK(openPageFile(TESTPF, &fh));
+
+  // grow the file in one step, the pages in between stay sparse
+  TEST_CHECK(ensureCapacity(PAST_4GB_PAGE + 1, &fh));
+  ASSERT_TRUE(fh.totalNumPages == PAST_4GB_PAGE + 1, "file grew past 4 GB");
+  ASSERT_TRUE(stat(TESTPF, &st) == 0 && st.st_size > (4LL << 30), "file size is larger than 4 GB");
+
+  // write pages on both sides of the boundary
+  fillPage(ph, PAST_4GB_PAGE);
+  TEST_CHECK(writeBlock(PAST_4GB_PAGE, &fh, ph));
+  fillPage(ph, PAST_4GB_PAGE - 2);
+  TEST_CHECK(writeBlock(PAST_4GB_PAGE - 2, &fh, ph));
+  TEST_CHECK(closePageFile(&fh));
+
+  // the page count survives a reopen and the pages read back unchanged
+  TEST_CHECK(openPageFile(TESTPF, &fh));
+  ASSERT_TRUE(fh.totalNumPages == PAST_4GB_PAGE + 1, "page count read back from the file header");
+  TEST_CHECK(readLastBlock(&fh, ph));
+  ASSERT_TRUE(checkPage(ph, PAST_4GB_PAGE), "page past 4 GB read back");
+  ASSERT_TRUE(getBlockPos(&fh) == PAST_4GB_PAGE, "current page position past 4 GB");
+  TEST_CHECK(readBlock(PAST_4GB_PAGE - 2, &fh, ph));
+  ASSERT_TRUE(checkPage(ph, PAST_4GB_PAGE - 2), "page before 4 GB read back");
+  TEST_CHECK(readNextBlock(&fh, ph));
+  ASSERT_TRUE(ph[0] == 0 && ph[PAGE_SIZE - 1] == 0, "page on the boundary is empty");
+  TEST_CHECK(closePageFile(&fh));
+
+  TEST_CHECK(destroyPageFile(TESTPF));
+  free(ph);
+
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testBufferPoolPast4GB (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  SM_FileHandle fh;
+  SM_PageHandle ph = (SM_PageHandle) malloc(PAGE_SIZE);
+
+  testName = "test pinning pages past 4 GB";
+
+  TEST_CHECK(createPageFile(TESTPF));
+  TEST_CHECK(initBufferPool(bm, TESTPF, 3, RS_FIFO, NULL));
+
+  // pinning a page beyond the end grows the file
+  TEST_CHECK(pinPage(bm, h, PAST_4GB_PAGE));
+  ASSERT_TRUE(h->pageNum == PAST_4GB_PAGE, "pinned page number past 4 GB");
+  fillPage(h->data, PAST_4GB_PAGE);
+  TEST_CHECK(markDirty(bm, h));
+  TEST_CHECK(unpinPage(bm, h));
+  ASSERT_TRUE(getFrameContents(bm)[0] == PAST_4GB_PAGE, "frame holds the page past 4 GB");
+  ASSERT_TRUE(pinPage(bm, h, (PageNumber) 1 << BM_PAGE_BITS) == RC_READ_NON_EXISTING_PAGE,
+              "page past the pool's page numbers not pinned");
+  ASSERT_TRUE(getFrameContents(bm)[1] == NO_PAGE, "no frame taken for it");
+  TEST_CHECK(shutdownBufferPool(bm));
+
+  // the flushed page is on disk at its 64 bit offset
+  TEST_CHECK(openPageFile(TESTPF, &fh));
+  ASSERT_TRUE(fh.totalNumPages == PAST_4GB_PAGE + 1, "pool grew the file past 4 GB");
+  TEST_CHECK(readBlock(PAST_4GB_PAGE, &fh, ph));
+  ASSERT_TRUE(checkPage(ph, PAST_4GB_PAGE), "flushed page read back");
+  TEST_CHECK(closePageFile(&fh));
+
+  TEST_CHECK(destroyPageFile(TESTPF));
+  free(ph);
+  free(bm);
+  free(h);
+
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testFreeListPast4GB (void)
+{
+  SM_FileHandle fh;
+  PageNumber pageNum;
+
+  testName = "test free list with pages past 4 GB";
+
+  TEST_CHECK(createPageFile(TESTPF));
+  TEST_CHECK(openPageFile(TESTPF, &fh));
+  TEST_CHECK(ensureCapacity(PAST_4GB_PAGE + 1, &fh));
+
+  // free two pages, the list links them by 64 bit page numbers
+  TEST_CHECK(freePage(PAST_4GB_PAGE, &fh));
+  TEST_CHECK(freePage(PAST_4GB_PAGE - 1, &fh));
+  ASSERT_TRUE(getNumFreePages(&fh) == 2, "two free pages");
+  ASSERT_TRUE(freePage(PAST_4GB_PAGE, &fh) == RC_PAGE_ALREADY_FREE, "page at the end of the list not freed twice");
+  ASSERT_TRUE(freePage(PAST_4GB_PAGE - 1, &fh) == RC_PAGE_ALREADY_FREE, "page at the head of the list not freed twice");
+  ASSERT_TRUE(getNumFreePages(&fh) == 2, "still two free pages");
+  TEST_CHECK(closePageFile(&fh));
+
+  // the list is kept in the file header and reused last-freed first
+  TEST_CHECK(openPageFile(TESTPF, &fh));
+  TEST_CHECK(allocatePage(&fh, &pageNum));
+  ASSERT_TRUE(pageNum == PAST_4GB_PAGE - 1, "reused the last freed page");
+  TEST_CHECK(allocatePage(&fh, &pageNum));
+  ASSERT_TRUE(pageNum == PAST_4GB_PAGE, "reused the page past 4 GB");
+  ASSERT_TRUE(getNumFreePages(&fh) == 0, "free list is empty");
+  TEST_CHECK(allocatePage(&fh, &pageNum));
+  ASSERT_TRUE(pageNum == PAST_4GB_PAGE + 1, "empty free list grows the file");
+  TEST_CHECK(closePageFile(&fh));
+
+  TEST_CHECK(destroyPageFile(TESTPF));
+
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+fillPage (SM_PageHandle page, PageNumber pageNum)
+{
+  for (int i = 0; i < PAGE_SIZE; i++)
+    page[i] = (pageNum + i) % 10 + '0';
+}
+
+// ************************************************************
+bool
+checkPage (SM_PageHandle page, PageNumber pageNum)
+{
+  for (int i = 0; i < PAGE_SIZE; i++)
+    if (page[i] != (pageNum + i) % 10 + '0')
+      return false;
+  return true;
+}
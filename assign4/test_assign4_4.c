@@ -0,0 +1,1348 @@
+#include "storage_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+#include "test_helper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// var to store the current test's name
+char *testName;
+
+// check whether two the content of a buffer pool is the same as an expected content
+// (given in the format produced by sprintPoolContent)
+#define ASSERT_EQUALS_POOL(expected,bm,message)			        \
+  do {									\
+    char *real;								\
+    char *_exp = (char *) (expected);                                   \
+    real = sprintPoolContent(bm);					\
+    if (strcmp((_exp),real) != 0)					\
+      {									\
+	printf("[%s-%s-L%i-%s] FAILED: expected <%s> but was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+	free(real);							\
+	exit(1);							\
+      }									\
+    printf("[%s-%s-L%i-%s] OK: expected <%s> and was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+    free(real);								\
+  } while(0)
+
+// test and helper methods
+static void createDummyPages(BM_BufferPool *bm, int num);
+
+static void testCLOCK (void);
+static void testLRU_K (void);
+static void testLFU (void);
+static void testARC (void);
+static void testScanRing (void);
+static void testPartitions (void);
+static void *pinPagesOfThread (void *arg);
+static void testOptimisticPins (void);
+static void testFailedRead (void);
+static void *pinHotPageOfThread (void *arg);
+static void testPinModes (void);
+static void *updateCounterOfThread (void *arg);
+static void testBackgroundCleaner (void);
+static void testPrefetch (void);
+static void testSharedPool (void);
+static void testResize (void);
+static void testResizeLargeARC (void);
+static void testFrameArena (void);
+static void testWarmRestart (void);
+
+// main method
+int
+main (void)
+{
+  initStorageManager();
+  testName = "";
+
+  testCLOCK();
+  testLRU_K();
+  testLFU();
+  testARC();
+  testScanRing();
+  testPartitions();
+  testOptimisticPins();
+  testFailedRead();
+  testPinModes();
+  testBackgroundCleaner();
+  testPrefetch();
+  testSharedPool();
+  testResize();
+  testResizeLargeARC();
+  testFrameArena();
+  testWarmRestart();
+
+  return 0;
+}
+
+void
+createDummyPages(BM_BufferPool *bm, int num)
+{
+  int i;
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+
+  for (i = 0; i < num; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(h->data, "%s-%lld", "Page", h->pageNum);
+      CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm,h));
+    }
+
+  CHECK(shutdownBufferPool(bm));
+
+  free(h);
+}
+
+// overwrites the int at position 'field' of the header of the warm restart sidecar
+static void
+patchSidecar(int field, int value)
+{
+  FILE *sidecar = fopen("testbuffer.bin.warm", "r+b");
+
+  ASSERT_TRUE(sidecar != NULL && fseek(sidecar, field * sizeof(int), SEEK_SET) == 0 &&
+              fwrite(&value, sizeof(int), 1, sidecar) == 1, "patching the sidecar");
+  fclose(sidecar);
+}
+
+// test the CLOCK page replacement strategy
+void
+testCLOCK (void)
+{
+  // expected results
+  const char *poolContents[] = {
+    // read first five pages and directly unpin them
+    "[0 0],[-1 0],[-1 0],[-1 0],[-1 0]" ,
+    "[0 0],[1 0],[-1 0],[-1 0],[-1 0]",
+    "[0 0],[1 0],[2 0],[-1 0],[-1 0]",
+    "[0 0],[1 0],[2 0],[3 0],[-1 0]",
+    "[0 0],[1 0],[2 0],[3 0],[4 0]",
+    // every frame is referenced: the hand clears all bits and comes back to frame 0
+    "[5 0],[1 0],[2 0],[3 0],[4 0]",
+    // a hit only sets the reference bit of page 2
+    "[5 0],[1 0],[2 0],[3 0],[4 0]",
+    // page 2 gets a second chance, its neighbours do not
+    "[5 0],[6 0],[2 0],[3 0],[4 0]",
+    "[5 0],[6 0],[2 0],[7 0],[4 0]",
+    "[5 0],[6 0],[2 0],[7 0],[8 0]",
+    "[5 0],[6 0],[9 0],[7 0],[8 0]"
+  };
+  const int requests[] = {5,2,6,7,8,9};
+  const int numRequests = 6;
+
+  int i;
+  int snapshot = 0;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle *pinned = MAKE_PAGE_HANDLE();
+  testName = "Testing CLOCK page replacement";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 100);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 5, RS_CLOCK, NULL));
+
+  // reading first five pages linearly with direct unpin and no modifications
+  for(i = 0; i < 5; i++)
+  {
+      pinPage(bm, h, i);
+      unpinPage(bm, h);
+      ASSERT_EQUALS_POOL(poolContents[snapshot], bm, "check pool content reading in pages");
+      snapshot++;
+  }
+
+  // replace pages and check that it happens in CLOCK order
+  for(i = 0; i < numRequests; i++)
+  {
+      pinPage(bm, h, requests[i]);
+      unpinPage(bm, h);
+      ASSERT_EQUALS_POOL(poolContents[snapshot], bm, "check pool content using pages");
+      snapshot++;
+  }
+
+  // the hand skips a pinned frame without touching it
+  CHECK(pinPage(bm, pinned, 7));
+  CHECK(pinPage(bm, h, 10));
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_POOL("[10 0],[6 0],[9 0],[7 1],[8 0]", bm, "pinned page is not replaced");
+  CHECK(unpinPage(bm, pinned));
+
+  // check content of the page read through the replaced frame
+  CHECK(pinPage(bm, h, 10));
+  ASSERT_EQUALS_STRING("Page-10", h->data, "reading back dummy page content");
+  CHECK(unpinPage(bm, h));
+
+  // check number of write IOs
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(11, getNumReadIO(bm), "check number of read I/Os");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  free(pinned);
+  TEST_DONE();
+}
+
+// test the LRU_K page replacement strategy with K = 2
+void
+testLRU_K (void)
+{
+  // expected results
+  const char *poolContents[] = {
+    // a one-off scan only replaces pages that were used once
+    "[0 0],[1 0],[10 0]",
+    "[0 0],[1 0],[11 0]",
+    "[0 0],[1 0],[12 0]",
+    // page 10 keeps its first access in the retained history, so it is now used twice
+    "[0 0],[1 0],[10 0]",
+    "[16 0],[1 0],[10 0]"
+  };
+  const int requests[] = {10,11,12,10,16};
+  const int numRequests = 5;
+
+  int i;
+  int k = 2;
+  int snapshot = 0;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  testName = "Testing LRU_K page replacement";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 100);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU_K, &k));
+
+  // use pages 0 and 1 twice each
+  for(i = 0; i < 4; i++)
+  {
+      pinPage(bm, h, i % 2);
+      unpinPage(bm, h);
+  }
+  ASSERT_EQUALS_POOL("[0 0],[1 0],[-1 0]", bm, "check pool content reading in pages");
+
+  // scan over other pages and check that it happens in LRU_K order
+  for(i = 0; i < numRequests; i++)
+  {
+      pinPage(bm, h, requests[i]);
+      unpinPage(bm, h);
+      ASSERT_EQUALS_POOL(poolContents[snapshot], bm, "check pool content using pages");
+      snapshot++;
+  }
+
+  // check number of write IOs
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(7, getNumReadIO(bm), "check number of read I/Os");
+
+  CHECK(shutdownBufferPool(bm));
+
+  // K must be at least 1
+  k = 0;
+  ASSERT_ERROR(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU_K, &k), "LRU_K with K = 0");
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test the LFU page replacement strategy, with and without aging
+void
+testLFU (void)
+{
+  // expected results
+  const char *poolContents[] = {
+    // the page used least often goes first
+    "[0 0],[1 0],[3 0]",
+    "[0 0],[1 0],[4 0]",
+    // a hit on page 4 does not change the pool content
+    "[0 0],[1 0],[4 0]",
+    // pages 1 and 4 were both used twice, page 1 longer ago
+    "[0 0],[5 0],[4 0]"
+  };
+  const int requests[] = {3,4,4,5};
+  const int numRequests = 4;
+  const int uses[] = {0,0,0,1,1,2};
+  const int agingRequests[] = {0,0,0,0,1,1,1,2};
+
+  int i;
+  int snapshot = 0;
+  int agingInterval = 4;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  testName = "Testing LFU page replacement";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 100);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LFU, NULL));
+
+  // use page 0 three times, page 1 twice and page 2 once
+  for(i = 0; i < 6; i++)
+  {
+      pinPage(bm, h, uses[i]);
+      unpinPage(bm, h);
+  }
+  ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0]", bm, "check pool content reading in pages");
+
+  // replace pages and check that it happens in LFU order
+  for(i = 0; i < numRequests; i++)
+  {
+      pinPage(bm, h, requests[i]);
+      unpinPage(bm, h);
+      ASSERT_EQUALS_POOL(poolContents[snapshot], bm, "check pool content using pages");
+      snapshot++;
+  }
+
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(6, getNumReadIO(bm), "check number of read I/Os");
+  CHECK(shutdownBufferPool(bm));
+
+  // without aging page 0 keeps its four uses and page 1 is replaced
+  CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LFU, NULL));
+  for(i = 0; i < 8; i++)
+  {
+      pinPage(bm, h, agingRequests[i]);
+      unpinPage(bm, h);
+  }
+  ASSERT_EQUALS_POOL("[0 0],[2 0]", bm, "old hot page stays without aging");
+  CHECK(shutdownBufferPool(bm));
+
+  // halving the counts every 4 pins lets the old hot page go
+  CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LFU, &agingInterval));
+  for(i = 0; i < 8; i++)
+  {
+      pinPage(bm, h, agingRequests[i]);
+      unpinPage(bm, h);
+  }
+  ASSERT_EQUALS_POOL("[2 0],[1 0]", bm, "old hot page leaves with aging");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test the ARC page replacement strategy
+void
+testARC (void)
+{
+  // expected results
+  const char *poolContents[] = {
+    // new pages replace pages that were only used once
+    "[0 0],[1 0],[10 0],[3 0]",
+    "[0 0],[1 0],[10 0],[11 0]",
+    "[0 0],[1 0],[12 0],[11 0]",
+    // page 10 is remembered as recently evicted: T1 grows and keeps page 12
+    "[0 0],[1 0],[12 0],[10 0]",
+    "[13 0],[1 0],[12 0],[10 0]",
+    // page 0 is remembered from T2: T1 shrinks again and gives up page 12
+    "[13 0],[1 0],[0 0],[10 0]"
+  };
+  const int requests[] = {10,11,12,10,13,0};
+  const int numRequests = 6;
+
+  int i;
+  int snapshot = 0;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  testName = "Testing ARC page replacement";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 100);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_ARC, NULL));
+
+  // use pages 0 and 1 twice each, pages 2 and 3 once
+  for(i = 0; i < 6; i++)
+  {
+      pinPage(bm, h, i < 4 ? i % 2 : i - 2);
+      unpinPage(bm, h);
+  }
+  ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0],[3 0]", bm, "check pool content reading in pages");
+
+  // replace pages and check that it happens in ARC order
+  for(i = 0; i < numRequests; i++)
+  {
+      pinPage(bm, h, requests[i]);
+      unpinPage(bm, h);
+      ASSERT_EQUALS_POOL(poolContents[snapshot], bm, "check pool content using pages");
+      snapshot++;
+  }
+
+  // check content of the page read back from the ghost list
+  CHECK(pinPage(bm, h, 0));
+  ASSERT_EQUALS_STRING("Page-0", h->data, "reading back dummy page content");
+  CHECK(unpinPage(bm, h));
+
+  // check number of write IOs
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(10, getNumReadIO(bm), "check number of read I/Os");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test that a scan through a ring only recycles its own frames
+void
+testScanRing (void)
+{
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle *held = MAKE_PAGE_HANDLE();
+  BM_ScanRing *ring;
+  char expected[16];
+  testName = "Testing scans through a ring of frames";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 100);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 8, RS_LRU, NULL));
+
+  // the ring of an 8 frame pool is capped at one frame
+  ASSERT_ERROR(createScanRing(bm, 0, &ring), "ring without frames");
+  CHECK(createScanRing(bm, 4, &ring));
+
+  // load the working set
+  for(i = 0; i < 6; i++)
+  {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+  }
+
+  // scan ten pages, they all pass through the same frame
+  for(i = 10; i < 20; i++)
+  {
+      CHECK(pinPageWithRing(bm, h, i, ring));
+      sprintf(expected, "%s-%i", "Page", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading page through the ring");
+      CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0],[3 0],[4 0],[5 0],[19 0],[-1 0]", bm, "scan kept the working set");
+
+  // a pinned ring frame is not recycled, the ring moves on to another frame
+  CHECK(pinPageWithRing(bm, held, 19, ring));
+  CHECK(pinPageWithRing(bm, h, 20, ring));
+  ASSERT_EQUALS_STRING("Page-20", h->data, "reading page into a new ring frame");
+  CHECK(unpinPage(bm, h));
+  CHECK(unpinPage(bm, held));
+  ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0],[3 0],[4 0],[5 0],[19 0],[20 0]", bm, "pinned ring frame kept");
+
+  // the working set is still cached
+  for(i = 0; i < 6; i++)
+  {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(17, getNumReadIO(bm), "check number of read I/Os");
+
+  CHECK(freeScanRing(ring));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  free(held);
+  TEST_DONE();
+}
+
+// worker of testPartitions: pins the pages assigned to one thread and checks their content
+#define NUM_THREADS 4
+static BM_BufferPool *sharedPool;
+static int threadErrors[NUM_THREADS];
+
+void *
+pinPagesOfThread (void *arg)
+{
+  int thread = (int) (long) arg;
+  unsigned int seed = thread + 1;
+  BM_PageHandle h;
+  char expected[32];
+  int i;
+
+  for(i = 0; i < 2000; i++)
+  {
+      // every thread owns the pages congruent to its number
+      PageNumber pageNum = (rand_r(&seed) % 25) * NUM_THREADS + thread;
+      if (pinPage(sharedPool, &h, pageNum) != RC_OK)
+      {
+          threadErrors[thread]++;
+          continue;
+      }
+      sprintf(expected, "%s-%lld", "Page", pageNum);
+      if (strcmp(expected, h.data) != 0)
+        threadErrors[thread]++;
+      if (i % 4 == 0 && markDirty(sharedPool, &h) != RC_OK)
+        threadErrors[thread]++;
+      if (unpinPage(sharedPool, &h) != RC_OK)
+        threadErrors[thread]++;
+  }
+  return NULL;
+}
+
+// test a pool split into partitions, from one and from several threads
+void
+testPartitions (void)
+{
+  int i;
+  long thread;
+  int errors = 0;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = { .directIO = false, .numPartitions = 3 };
+  pthread_t threads[NUM_THREADS];
+  char expected[16];
+  testName = "Testing partitioned buffer pools";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 100);
+
+  // every partition needs a frame
+  options.numPartitions = 7;
+  ASSERT_ERROR(initBufferPoolWithOptions(bm, "testbuffer.bin", 6, RS_FIFO, NULL, &options), "more partitions than frames");
+
+  // pages are found again in their partition
+  options.numPartitions = 3;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 6, RS_CLOCK, NULL, &options));
+  for(i = 0; i < 30; i++)
+  {
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, "%s-%i", "Page", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading page through its partition");
+      CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_INT(30, getNumReadIO(bm), "check number of read I/Os");
+  for(i = 0; i < 6; i++)
+    if (getFrameContents(bm)[i] == NO_PAGE)
+      errors++;
+  ASSERT_EQUALS_INT(0, errors, "all partitions hold pages");
+  CHECK(shutdownBufferPool(bm));
+
+  // threads pinning their own pages at the same time
+  options.numPartitions = 4;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 16, RS_LRU, NULL, &options));
+  sharedPool = bm;
+  for(thread = 0; thread < NUM_THREADS; thread++)
+    pthread_create(&threads[thread], NULL, pinPagesOfThread, (void *) thread);
+  for(thread = 0; thread < NUM_THREADS; thread++)
+  {
+      pthread_join(threads[thread], NULL);
+      errors += threadErrors[thread];
+  }
+  ASSERT_EQUALS_INT(0, errors, "concurrent pins read the right pages");
+  for(i = 0; i < 16; i++)
+    errors += getFixCounts(bm)[i];
+  ASSERT_EQUALS_INT(0, errors, "no page left pinned");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// worker of testOptimisticPins: alternates between the shared hot page and its own pages
+void *
+pinHotPageOfThread (void *arg)
+{
+  int thread = (int) (long) arg;
+  unsigned int seed = thread + 1;
+  BM_PageHandle hot;
+  BM_PageHandle h;
+  char expected[32];
+  int i;
+
+  for(i = 0; i < 2000; i++)
+  {
+      if (pinPage(sharedPool, &hot, 0) != RC_OK || strcmp("Page-0", hot.data) != 0)
+        threadErrors[thread]++;
+
+      // other pages are read in around the pinned hot page
+      PageNumber pageNum = 1 + (rand_r(&seed) % 24) * NUM_THREADS + thread;
+      if (pinPage(sharedPool, &h, pageNum) != RC_OK)
+        threadErrors[thread]++;
+      sprintf(expected, "%s-%lld", "Page", pageNum);
+      if (strcmp(expected, h.data) != 0)
+        threadErrors[thread]++;
+      if (unpinPage(sharedPool, &h) != RC_OK || unpinPage(sharedPool, &hot) != RC_OK)
+        threadErrors[thread]++;
+  }
+  return NULL;
+}
+
+// test that threads share a hot page through the optimistic pin path
+void
+testOptimisticPins (void)
+{
+  int i;
+  long thread;
+  int errors = 0;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = { .directIO = false, .numPartitions = 2 };
+  pthread_t threads[NUM_THREADS];
+  testName = "Testing optimistic pins of cached pages";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 100);
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 16, RS_CLOCK, NULL, &options));
+
+  // a hit does not read the page again
+  CHECK(pinPage(bm, h, 0));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 0));
+  ASSERT_EQUALS_STRING("Page-0", h->data, "hit on a cached page");
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_INT(1, getNumReadIO(bm), "check number of read I/Os");
+
+  // every thread keeps the hot page pinned while it reads other pages
+  sharedPool = bm;
+  memset(threadErrors, 0, sizeof(threadErrors));
+  for(thread = 0; thread < NUM_THREADS; thread++)
+    pthread_create(&threads[thread], NULL, pinHotPageOfThread, (void *) thread);
+  for(thread = 0; thread < NUM_THREADS; thread++)
+  {
+      pthread_join(threads[thread], NULL);
+      errors += threadErrors[thread];
+  }
+  ASSERT_EQUALS_INT(0, errors, "concurrent pins of the hot page");
+  for(i = 0; i < 16; i++)
+    errors += getFixCounts(bm)[i];
+  ASSERT_EQUALS_INT(0, errors, "no page left pinned");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// a pin whose read fails leaves nothing of the page behind, under every strategy
+void
+testFailedRead (void)
+{
+  int i;
+  int s;
+  int k = 2;
+  RC rc;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  testName = "Testing pins whose read fails";
+
+  for(s = RS_FIFO; s <= RS_ARC; s++)
+  {
+      CHECK(createPageFile("testbuffer.bin"));
+      createDummyPages(bm, 10);
+      CHECK(initBufferPool(bm, "testbuffer.bin", 3, s, s == RS_LRU_K ? &k : NULL));
+      for(i = 0; i < 3; i++)
+      {
+          CHECK(pinPage(bm, h, i));
+          CHECK(unpinPage(bm, h));
+      }
+
+      // the file loses pages 5 to 9 behind the pool's back: the header block and 5 pages stay
+      ASSERT_TRUE(truncate("testbuffer.bin", 6 * PAGE_SIZE) == 0, "cutting the page file short");
+      rc = pinPage(bm, h, 5);
+      ASSERT_EQUALS_INT(RC_FILE_HANDLE_NOT_INIT, rc, "error of the failed pread returned");
+      ASSERT_EQUALS_POOL("[-1 0],[1 0],[2 0]", bm, "page of the failed read not mapped");
+      ASSERT_ERROR(pinPage(bm, h, 5), "page of the failed read read again");
+      ASSERT_EQUALS_INT(3, getNumReadIO(bm), "failed reads not counted");
+
+      CHECK(pinPage(bm, h, 3));
+      CHECK(unpinPage(bm, h));
+      ASSERT_EQUALS_POOL("[3 0],[1 0],[2 0]", bm, "emptied frame evicted first");
+      CHECK(shutdownBufferPool(bm));
+      CHECK(destroyPageFile("testbuffer.bin"));
+  }
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// offset of the counter testPinModes keeps in page 0, past the "Page-0" text
+#define COUNTER_OFFSET 64
+#define COUNTER_UPDATES 2000
+
+// worker of testPinModes: increments the counter under write pins and checks, under
+// read pins, that both copies of it agree
+void *
+updateCounterOfThread (void *arg)
+{
+  int thread = (int) (long) arg;
+  BM_PageHandle h;
+  int counter;
+  int copy;
+  int i;
+
+  for(i = 0; i < COUNTER_UPDATES; i++)
+  {
+      if (pinPageForWrite(sharedPool, &h, 0) != RC_OK)
+      {
+          threadErrors[thread]++;
+          continue;
+      }
+      memcpy(&counter, h.data + COUNTER_OFFSET, sizeof(int));
+      counter++;
+      memcpy(h.data + COUNTER_OFFSET, &counter, sizeof(int));
+      memcpy(h.data + COUNTER_OFFSET + sizeof(int), &counter, sizeof(int));
+      if (markDirty(sharedPool, &h) != RC_OK || unpinPage(sharedPool, &h) != RC_OK)
+        threadErrors[thread]++;
+
+      if (pinPageForRead(sharedPool, &h, 0) != RC_OK)
+      {
+          threadErrors[thread]++;
+          continue;
+      }
+      memcpy(&counter, h.data + COUNTER_OFFSET, sizeof(int));
+      memcpy(&copy, h.data + COUNTER_OFFSET + sizeof(int), sizeof(int));
+      if (counter != copy || unpinPage(sharedPool, &h) != RC_OK)
+        threadErrors[thread]++;
+  }
+  return NULL;
+}
+
+// test pins for read and write: pins of one page add up and writers exclude each other
+void
+testPinModes (void)
+{
+  int i;
+  long thread;
+  int errors = 0;
+  int counter;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle *reader1 = MAKE_PAGE_HANDLE();
+  BM_PageHandle *reader2 = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = { .directIO = false, .numPartitions = 2 };
+  pthread_t threads[NUM_THREADS];
+  testName = "Testing pins for read and write";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 100);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+
+  // two readers share one frame and one read
+  CHECK(pinPageForRead(bm, reader1, 0));
+  CHECK(pinPageForRead(bm, reader2, 0));
+  ASSERT_EQUALS_POOL("[0 2],[-1 0],[-1 0]", bm, "two readers pin page 0");
+  ASSERT_EQUALS_INT(1, getNumReadIO(bm), "check number of read I/Os");
+  ASSERT_TRUE(reader1->data == reader2->data, "readers share the frame");
+  ASSERT_TRUE(markDirty(bm, reader1) == RC_PAGE_PINNED_FOR_READ, "a reader cannot mark the page dirty");
+
+  // the page stays pinned until its last reader unpins it
+  CHECK(unpinPage(bm, reader1));
+  ASSERT_EQUALS_POOL("[0 1],[-1 0],[-1 0]", bm, "one reader left");
+  CHECK(pinPage(bm, h, 1));
+  CHECK(pinPage(bm, h, 2));
+  ASSERT_ERROR(pinPage(bm, h, 3), "page 0 is not evicted under its second reader");
+  CHECK(unpinPage(bm, reader2));
+  CHECK(pinPage(bm, h, 3));
+  ASSERT_EQUALS_POOL("[3 1],[1 1],[2 1]", bm, "page 0 evicted after its last reader");
+  for(i = 1; i <= 3; i++)
+  {
+      h->pageNum = i;
+      CHECK(unpinPage(bm, h));
+  }
+  CHECK(shutdownBufferPool(bm));
+
+  // concurrent writers of one page do not lose updates, readers see no torn writes
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 8, RS_LRU, NULL, &options));
+  CHECK(pinPageForWrite(bm, h, 0));
+  memset(h->data + COUNTER_OFFSET, 0, 2 * sizeof(int));
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  sharedPool = bm;
+  memset(threadErrors, 0, sizeof(threadErrors));
+  for(thread = 0; thread < NUM_THREADS; thread++)
+    pthread_create(&threads[thread], NULL, updateCounterOfThread, (void *) thread);
+  for(thread = 0; thread < NUM_THREADS; thread++)
+  {
+      pthread_join(threads[thread], NULL);
+      errors += threadErrors[thread];
+  }
+  ASSERT_EQUALS_INT(0, errors, "concurrent pins for read and write");
+  CHECK(pinPageForRead(bm, h, 0));
+  memcpy(&counter, h->data + COUNTER_OFFSET, sizeof(int));
+  ASSERT_EQUALS_INT(NUM_THREADS * COUNTER_UPDATES, counter, "no update lost");
+  CHECK(unpinPage(bm, h));
+  for(i = 0; i < 8; i++)
+    errors += getFixCounts(bm)[i];
+  ASSERT_EQUALS_INT(0, errors, "no page left pinned");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  free(reader1);
+  free(reader2);
+  TEST_DONE();
+}
+
+// test that the background cleaner writes dirty pages before they are evicted
+void
+testBackgroundCleaner (void)
+{
+  int i;
+  int wait;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = { .backgroundCleaner = true, .dirtyHighWatermark = 25, .dirtyLowWatermark = 50 };
+  char expected[16];
+  testName = "Testing the background page cleaner";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 100);
+
+  ASSERT_ERROR(initBufferPoolWithOptions(bm, "testbuffer.bin", 8, RS_FIFO, NULL, &options), "low watermark above the high one");
+
+  // dirty six of eight frames; pinned frames are left alone
+  options.dirtyHighWatermark = 50;
+  options.dirtyLowWatermark = 25;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 8, RS_FIFO, NULL, &options));
+  for(i = 0; i < 6; i++)
+  {
+      CHECK(pinPage(bm, h, i));
+      sprintf(h->data, "%s-%i", "Dirty", i);
+      CHECK(markDirty(bm, h));
+  }
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "nothing written while the pages are pinned");
+  for(i = 0; i < 6; i++)
+  {
+      h->pageNum = i;
+      CHECK(unpinPage(bm, h));
+  }
+
+  // the oldest pages are written until two dirty frames are left
+  for(wait = 0; wait < 200 && getNumWriteIO(bm) < 4; wait++)
+    usleep(10000);
+  ASSERT_EQUALS_INT(4, getNumWriteIO(bm), "cleaner wrote down to the low watermark");
+  ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0],[3 0],[4x0],[5x0],[-1 0],[-1 0]", bm, "pages at the eviction end are clean");
+
+  // misses evict the cleaned pages without writing them
+  for(i = 6; i < 12; i++)
+  {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_INT(4, getNumWriteIO(bm), "clean victims need no write");
+  CHECK(shutdownBufferPool(bm));
+
+  // every change reached the file
+  CHECK(initBufferPool(bm, "testbuffer.bin", 8, RS_FIFO, NULL));
+  for(i = 0; i < 6; i++)
+  {
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, "%s-%i", "Dirty", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "page written by the cleaner or the shutdown");
+      CHECK(unpinPage(bm, h));
+  }
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test prefetching pages and reading ahead of sequential pins
+void
+testPrefetch (void)
+{
+  int i;
+  int s;
+  int k = 2;
+  int errors = 0;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = { .readAheadPages = 8 };
+  int arcPins[] = {0, 0, 1, 2, 3, 4, 1, 2};
+  char expected[16];
+  testName = "Testing prefetching and read-ahead";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 100);
+
+  // prefetched pages are pinned without another read
+  CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_FIFO, NULL));
+  CHECK(prefetchPages(bm, 0, 3));
+  for(i = 0; i < 3; i++)
+    if (getFrameContents(bm)[i] != i)
+      errors++;
+  ASSERT_EQUALS_INT(0, errors, "prefetch maps the pages to frames");
+  for(i = 0; i < 3; i++)
+  {
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, "%s-%i", "Page", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading prefetched page");
+      CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0],[-1 0]", bm, "prefetched pages are not left pinned");
+  CHECK(prefetchPages(bm, 1, 2));
+  ASSERT_EQUALS_INT(3, getNumReadIO(bm), "cached pages are not prefetched again");
+
+  // a prefetch takes free or clean frames only
+  CHECK(pinPage(bm, h, 3));
+  CHECK(unpinPage(bm, h));
+  h->pageNum = 0;
+  CHECK(markDirty(bm, h));
+  CHECK(prefetchPages(bm, 4, 1));
+  ASSERT_EQUALS_POOL("[0x0],[1 0],[2 0],[3 0]", bm, "dirty victim is not replaced by a prefetch");
+  CHECK(forceFlushPool(bm));
+  CHECK(prefetchPages(bm, 4, 1));
+  ASSERT_TRUE(getFrameContents(bm)[0] == 4, "clean victim is replaced by a prefetch");
+  ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "a prefetch does not write");
+  CHECK(prefetchPages(bm, 99, 10));
+  CHECK(shutdownBufferPool(bm));
+  ASSERT_ERROR(prefetchPages(bm, 0, 1), "prefetch in a pool that is not open");
+
+  // under ARC the victim comes from T2 once T1 is down to its target
+  CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_ARC, NULL));
+  // page 0 goes to T2; pages 1 and 2 come back from B1 into T2 and are changed, which
+  // pushes 0 into B2 and the target of T1 up to 2
+  for(i = 0; i < 8; i++)
+  {
+      CHECK(pinPage(bm, h, arcPins[i]));
+      if (i >= 6)
+        CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_POOL("[2x0],[4 0],[1x0],[3 0]", bm, "T1 at its target, dirty pages in T2");
+  CHECK(prefetchPages(bm, 5, 1));
+  ASSERT_EQUALS_POOL("[2x0],[4 0],[1x0],[3 0]", bm, "dirty T2 victim is not replaced by a prefetch");
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "a prefetch under ARC does not write");
+
+  // prefetching page 0, remembered in B2, neither moves the target nor files it in T2
+  CHECK(forceFlushPool(bm));
+  CHECK(prefetchPages(bm, 0, 1));
+  ASSERT_TRUE(getFrameContents(bm)[2] == 0 && getFrameContents(bm)[3] == 3, "clean T2 victim is replaced by a prefetch");
+  CHECK(pinPage(bm, h, 6));
+  CHECK(unpinPage(bm, h));
+  ASSERT_TRUE(getFrameContents(bm)[2] == 0 && getFrameContents(bm)[3] == 6, "T1 above its target after the prefetch");
+  CHECK(shutdownBufferPool(bm));
+
+  // sequential pins read ahead
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 16, RS_CLOCK, NULL, &options));
+  for(i = 0; i < 4; i++)
+  {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+  }
+  for(i = 4; i < 12; i++)
+    if (getFrameContents(bm)[i] != i)
+      errors++;
+  ASSERT_EQUALS_INT(0, errors, "four consecutive pins read eight pages ahead");
+  for(i = 4; i < 16; i++)
+  {
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, "%s-%i", "Page", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading page read ahead");
+      CHECK(unpinPage(bm, h));
+  }
+  // read-ahead restarted at pins 8 and 13, each time up to eight pages past the pin
+  ASSERT_EQUALS_INT(22, getNumReadIO(bm), "pages 0 to 21 read once each");
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  // a prefetch whose read fails again when retried leaves its frame empty
+  for(s = RS_FIFO; s <= RS_ARC; s++)
+  {
+      CHECK(createPageFile("testbuffer.bin"));
+      createDummyPages(bm, 10);
+      CHECK(initBufferPool(bm, "testbuffer.bin", 4, s, s == RS_LRU_K ? &k : NULL));
+      ASSERT_TRUE(truncate("testbuffer.bin", 6 * PAGE_SIZE) == 0, "cutting the page file short");
+      CHECK(prefetchPages(bm, 3, 4));
+      CHECK(pinPage(bm, h, 3));
+      ASSERT_EQUALS_STRING("Page-3", h->data, "reading prefetched page before the cut");
+      CHECK(unpinPage(bm, h));
+      ASSERT_ERROR(pinPage(bm, h, 5), "prefetched page past the cut not pinned");
+      ASSERT_ERROR(pinPage(bm, h, 6), "prefetched page past the cut not pinned");
+      ASSERT_EQUALS_POOL("[3 0],[4 0],[-1 0],[-1 0]", bm, "pages of the failed prefetches not mapped");
+      ASSERT_EQUALS_INT(2, getNumReadIO(bm), "failed prefetches not counted");
+      CHECK(pinPage(bm, h, 2));
+      CHECK(unpinPage(bm, h));
+      CHECK(pinPage(bm, h, 1));
+      CHECK(unpinPage(bm, h));
+      ASSERT_TRUE(getFrameContents(bm)[0] == 3 && getFrameContents(bm)[1] == 4, "emptied frames evicted first");
+      CHECK(shutdownBufferPool(bm));
+      CHECK(destroyPageFile("testbuffer.bin"));
+  }
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test one pool caching the pages of two page files
+void
+testSharedPool (void)
+{
+  int i;
+  BM_BufferPool *pool = MAKE_POOL();
+  BM_BufferPool *fileA = MAKE_POOL();
+  BM_BufferPool *fileB = MAKE_POOL();
+  BM_BufferPool *own = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  SM_FileHandle fh;
+  SM_PageHandle ph = (SM_PageHandle) malloc(PAGE_SIZE);
+  char expected[16];
+  testName = "Testing a pool shared by two page files";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(own, 4);
+  CHECK(createPageFile("testbuffer2.bin"));
+  CHECK(openPageFile("testbuffer2.bin", &fh));
+  CHECK(ensureCapacity(4, &fh));
+  for(i = 0; i < 4; i++)
+  {
+      memset(ph, 0, PAGE_SIZE);
+      sprintf(ph, "%s-%i", "Other", i);
+      CHECK(writeBlock(i, &fh, ph));
+  }
+  CHECK(closePageFile(&fh));
+
+  CHECK(initSharedBufferPool(pool, 4, RS_FIFO, NULL, NULL));
+  CHECK(attachPageFile(fileA, pool, "testbuffer.bin"));
+  CHECK(attachPageFile(fileB, pool, "testbuffer2.bin"));
+
+  // the same page number of both files, each in a frame of its own
+  CHECK(pinPage(fileA, h, 0));
+  ASSERT_EQUALS_STRING("Page-0", h->data, "reading page 0 of the first file");
+  CHECK(unpinPage(fileA, h));
+  CHECK(pinPage(fileB, h, 0));
+  ASSERT_EQUALS_STRING("Other-0", h->data, "reading page 0 of the second file");
+  sprintf(h->data, "%s-%i", "Changed", 0);
+  CHECK(markDirty(fileB, h));
+  CHECK(unpinPage(fileB, h));
+  ASSERT_EQUALS_POOL("[0 0],[-1 0],[-1 0],[-1 0]", fileA, "the first file sees its page only");
+  ASSERT_EQUALS_POOL("[-1 0],[0x0],[-1 0],[-1 0]", fileB, "the second file sees its page only");
+  ASSERT_EQUALS_POOL("[0 0],[0x0],[-1 0],[-1 0]", pool, "the shared pool sees the pages of both");
+
+  // a file that is used more takes over frames of the other one
+  for(i = 1; i <= 4; i++)
+  {
+      CHECK(pinPage(fileA, h, i % 4));
+      sprintf(expected, "%s-%i", "Page", i % 4);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading pages of the first file");
+      CHECK(unpinPage(fileA, h));
+  }
+  ASSERT_EQUALS_POOL("[-1 0],[-1 0],[-1 0],[-1 0]", fileB, "the second file's page was evicted");
+  ASSERT_EQUALS_POOL("[3 0],[0 0],[1 0],[2 0]", fileA, "the first file holds all frames");
+  ASSERT_EQUALS_INT(1, getNumWriteIO(pool), "dirty page of the second file written on eviction");
+  CHECK(pinPage(fileB, h, 0));
+  ASSERT_EQUALS_STRING("Changed-0", h->data, "evicted page written to the second file");
+  CHECK(unpinPage(fileB, h));
+
+  // a file is detached once its pages are unpinned, the pool outlives it
+  CHECK(pinPage(fileA, h, 2));
+  ASSERT_ERROR(shutdownBufferPool(fileA), "detaching a file with a pinned page");
+  CHECK(unpinPage(fileA, h));
+  CHECK(markDirty(fileA, h));
+  ASSERT_ERROR(shutdownBufferPool(pool), "shutting down a pool with attached files");
+  CHECK(shutdownBufferPool(fileA));
+  ASSERT_EQUALS_INT(2, getNumWriteIO(pool), "dirty page flushed when its file is detached");
+  ASSERT_EQUALS_POOL("[-1 0],[-1 0],[0 0],[-1 0]", pool, "pages of a detached file are not reported");
+  CHECK(attachPageFile(fileA, pool, "testbuffer.bin"));
+  CHECK(pinPage(fileA, h, 2));
+  ASSERT_EQUALS_STRING("Page-2", h->data, "reading the flushed page after attaching again");
+  CHECK(unpinPage(fileA, h));
+
+  // files attach to shared pools only, and the shared pool's handle pins nothing
+  CHECK(initBufferPool(own, "testbuffer.bin", 3, RS_FIFO, NULL));
+  ASSERT_ERROR(attachPageFile(fileB, own, "testbuffer2.bin"), "attaching a file to a pool of its own");
+  CHECK(shutdownBufferPool(own));
+  ASSERT_ERROR(pinPage(pool, h, 0), "pinning a page through the shared pool's handle");
+
+  CHECK(shutdownBufferPool(fileA));
+  CHECK(shutdownBufferPool(fileB));
+  CHECK(shutdownBufferPool(pool));
+  CHECK(destroyPageFile("testbuffer.bin"));
+  CHECK(destroyPageFile("testbuffer2.bin"));
+
+  free(pool);
+  free(fileA);
+  free(fileB);
+  free(own);
+  free(h);
+  free(ph);
+  TEST_DONE();
+}
+
+// resize an LRU_K pool: the pages and their histories survive, shrinking evicts in LRU_K order
+void
+testResize (void)
+{
+  int i;
+  int k = 2;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  testName = "Testing online resizes of a pool";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_LRU_K, &k));
+
+  // pages 0 and 1 are used twice, 2 and 3 once; 3 is changed
+  for(i = 0; i < 4; i++)
+  {
+      CHECK(pinPage(bm, h, i % 2));
+      CHECK(unpinPage(bm, h));
+  }
+  CHECK(pinPage(bm, h, 2));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 3));
+  sprintf(h->data, "%s-%i", "Changed", 3);
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+
+  // growing keeps every page, in LRU_K order, and adds free frames
+  CHECK(resizeBufferPool(bm, 6));
+  ASSERT_EQUALS_INT(6, bm->numPages, "pool has grown");
+  ASSERT_EQUALS_POOL("[2 0],[3x0],[0 0],[1 0],[-1 0],[-1 0]", bm, "pages kept when growing");
+  CHECK(pinPage(bm, h, 4));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 5));
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_POOL("[2 0],[3x0],[0 0],[1 0],[4 0],[5 0]", bm, "new frames used without evictions");
+  ASSERT_EQUALS_INT(6, getNumReadIO(bm), "no page read again after growing");
+
+  // shrinking evicts what LRU_K would evict first and writes the dirty page
+  CHECK(resizeBufferPool(bm, 3));
+  ASSERT_EQUALS_INT(3, bm->numPages, "pool has shrunk");
+  ASSERT_EQUALS_POOL("[5 0],[0 0],[1 0]", bm, "pages used twice kept when shrinking");
+  ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "dirty page written when it is evicted by the shrink");
+  CHECK(pinPage(bm, h, 6));
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_POOL("[6 0],[0 0],[1 0]", bm, "histories survive the shrink");
+  CHECK(pinPage(bm, h, 3));
+  ASSERT_EQUALS_STRING("Changed-3", h->data, "reading the page written by the shrink");
+
+  // not while pages are pinned, and never below one frame per partition
+  ASSERT_ERROR(resizeBufferPool(bm, 4), "resizing a pool with a pinned page");
+  CHECK(unpinPage(bm, h));
+  ASSERT_ERROR(resizeBufferPool(bm, 0), "resizing a pool to no frames");
+  ASSERT_EQUALS_INT(3, bm->numPages, "failed resizes keep the size");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// resizing a large ARC pool whose target times the new size no longer fits an int
+void
+testResizeLargeARC (void)
+{
+  int i;
+  int frames = 8192;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  char expected[256];
+  testName = "Testing resizes of a large ARC pool";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 2 * frames + 18);
+  CHECK(initBufferPool(bm, "testbuffer.bin", frames, RS_ARC, NULL));
+
+  // fill T2, then push all of it into B2 with pages that go straight to T2 too
+  for(i = 0; i < 4 * frames; i++)
+  {
+      CHECK(pinPage(bm, h, i / 2));
+      CHECK(unpinPage(bm, h));
+  }
+  // one B1 hit against a full B2 takes the target up to about the pool size
+  for(i = 0; i < 3; i++)
+  {
+      CHECK(pinPage(bm, h, 2 * frames + i % 2));
+      CHECK(unpinPage(bm, h));
+  }
+
+  // target * 300000 overflows an int: the grown target must stay the whole pool
+  CHECK(resizeBufferPool(bm, 300000));
+  ASSERT_EQUALS_INT(300000, bm->numPages, "large pool has grown");
+  for(i = 0; i < 16; i++)
+  {
+      CHECK(pinPage(bm, h, 2 * frames + 2 + i));
+      CHECK(unpinPage(bm, h));
+  }
+
+  // with the target at the pool size, the shrink evicts T2 first and keeps the new T1 pages
+  CHECK(resizeBufferPool(bm, 16));
+  ASSERT_EQUALS_INT(16, bm->numPages, "large pool has shrunk");
+  expected[0] = '\0';
+  for(i = 0; i < 16; i++)
+      sprintf(expected + strlen(expected), "%s[%i 0]", i ? "," : "", 2 * frames + 2 + i);
+  ASSERT_EQUALS_POOL(expected, bm, "recently used pages kept by the shrink");
+  CHECK(pinPage(bm, h, 2 * frames + 2));
+  ASSERT_EQUALS_STRING("Page-16386", h->data, "reading a page kept by the shrink");
+  CHECK(unpinPage(bm, h));
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// frames in a prefaulted huge page arena: aligned for direct I/O, through resizes too
+void
+testFrameArena (void)
+{
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = {0};
+  char expected[16];
+  testName = "Testing frames in a huge page arena";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 40);
+  options.directIO = TRUE;
+  options.numPartitions = 2;
+  options.hugePages = TRUE;
+  options.prefaultFrames = TRUE;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 16, RS_CLOCK, NULL, &options));
+
+  for(i = 0; i < 40; i++)
+  {
+      CHECK(pinPage(bm, h, i));
+      ASSERT_TRUE((unsigned long) h->data % PAGE_SIZE == 0, "frames are page aligned");
+      sprintf(expected, "%s-%i", "Page", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading pages into the arena");
+      if (i % 3 == 0)
+      {
+          sprintf(h->data, "%s-%i", "Changed", i);
+          CHECK(markDirty(bm, h));
+      }
+      CHECK(unpinPage(bm, h));
+      if (i == 20)
+      {
+          CHECK(resizeBufferPool(bm, 40));
+      }
+  }
+  CHECK(resizeBufferPool(bm, 8));
+  CHECK(pinPage(bm, h, 39));
+  ASSERT_TRUE((unsigned long) h->data % PAGE_SIZE == 0, "frames stay page aligned after a resize");
+  ASSERT_EQUALS_STRING("Changed-39", h->data, "page kept in the new arena");
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+
+  // every change reached the file
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  for(i = 0; i < 40; i += 3)
+  {
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, "%s-%i", "Changed", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "changes written from the arena");
+      CHECK(unpinPage(bm, h));
+  }
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// a pool saved at shutdown starts again with its pages and their LRU_K histories
+void
+testWarmRestart (void)
+{
+  int i;
+  int k = 2;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = {0};
+  testName = "Testing warm restarts of a pool";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+  remove("testbuffer.bin.warm"); // left behind by an earlier failed run
+  options.warmRestart = TRUE;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 4, RS_LRU_K, &k, &options));
+  ASSERT_EQUALS_POOL("[-1 0],[-1 0],[-1 0],[-1 0]", bm, "no saved pages on the first start");
+
+  // pages 0 and 1 are used twice, 2 and 3 once; 3 is changed
+  for(i = 0; i < 4; i++)
+  {
+      CHECK(pinPage(bm, h, i % 2));
+      CHECK(unpinPage(bm, h));
+  }
+  CHECK(pinPage(bm, h, 2));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 3));
+  sprintf(h->data, "%s-%i", "Changed", 3);
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+
+  // the pages come back in LRU_K order, read from the file, and keep their histories
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 4, RS_LRU_K, &k, &options));
+  ASSERT_EQUALS_POOL("[2 0],[3 0],[0 0],[1 0]", bm, "saved pages reloaded");
+  ASSERT_EQUALS_INT(4, getNumReadIO(bm), "saved pages read at start");
+  CHECK(pinPage(bm, h, 3));
+  ASSERT_EQUALS_STRING("Changed-3", h->data, "reloaded page has the data of the file");
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_INT(4, getNumReadIO(bm), "reloaded page is a hit");
+  CHECK(pinPage(bm, h, 6));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 7));
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_POOL("[7 0],[3 0],[0 0],[1 0]", bm, "pages used twice across the restart stay");
+  CHECK(shutdownBufferPool(bm));
+
+  // a smaller pool with another strategy takes the most valuable pages
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 2, RS_FIFO, NULL, &options));
+  ASSERT_EQUALS_POOL("[1 0],[3 0]", bm, "smaller pool keeps the pages LRU_K valued most");
+  CHECK(shutdownBufferPool(bm));
+
+  // a damaged sidecar leaves the pool cold: a page count the file does not hold, a K
+  // without LRU_K, a record cut short
+  for(i = 0; i < 3; i++)
+  {
+      if (i < 2)
+        patchSidecar(i == 0 ? 3 : 2, i == 0 ? 1 << 30 : 1);
+      else
+        ASSERT_TRUE(truncate("testbuffer.bin.warm", 40) == 0, "cutting the sidecar short");
+      CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 2, RS_FIFO, NULL, &options));
+      ASSERT_EQUALS_POOL("[-1 0],[-1 0]", bm, "damaged sidecar ignored");
+      ASSERT_EQUALS_INT(0, getNumReadIO(bm), "nothing read from a damaged sidecar");
+      CHECK(pinPage(bm, h, 1));
+      CHECK(unpinPage(bm, h));
+      CHECK(pinPage(bm, h, 3));
+      CHECK(unpinPage(bm, h));
+      CHECK(shutdownBufferPool(bm));
+  }
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 2, RS_FIFO, NULL, &options));
+  ASSERT_EQUALS_POOL("[1 0],[3 0]", bm, "sidecar written again after a cold start");
+  CHECK(shutdownBufferPool(bm));
+
+  // shared pools do not know their files at start
+  ASSERT_ERROR(initSharedBufferPool(bm, 4, RS_FIFO, NULL, &options), "warm restart of a shared pool");
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+  ASSERT_TRUE(remove("testbuffer.bin.warm") == 0, "pages saved next to the page file");
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}